@@ -6,48 +6,211 @@
 #include <iostream>
 #include <stdexcept>
 #include <unordered_map>
+#include "aig_types.h"
+#include "node_store.h"
+#include "strash_table.h"
+#include <memory>
+#include <string>
 
 // -------------------------
 // 节点表示
 // -------------------------
 struct AigNode {
-    uint32_t fanin0 = 0;
-    uint32_t fanin1 = 0;
+    AigLit fanin0 = 0;
+    AigLit fanin1 = 0;
     bool is_input = false;
+    bool phase = false;     // 物理实现的极性：true 表示以反相形式 (NAND) 实现
 };
 
+// 节点存储的排列：默认每个节点一个结构体；CMake 选项 AIG_SOA_NODES
+// 打开后按字段分数组 (见 soa_layout.h)。两者接口相同
+#ifdef AIG_SOA_NODES
+#include "soa_layout.h"
+using NodeStore = ChunkedStore<AigNode, SoaLayout>;
+#else
+using NodeStore = ChunkedStore<AigNode>;
+#endif
+
 // -------------------------
 // 字面量操作
 // -------------------------
-static inline uint32_t make_lit(uint32_t id, bool inv=false) {
-    return (id << 1) | static_cast<uint32_t>(inv);
+static inline AigLit make_lit(AigId id, bool inv=false) {
+    return (id << 1) | static_cast<AigLit>(inv);
 }
 
-static inline uint32_t lit_id(uint32_t lit) {
+static inline AigId lit_id(AigLit lit) {
     return lit >> 1;
 }
 
-static inline bool lit_inv(uint32_t lit) {
+static inline bool lit_inv(AigLit lit) {
     return lit & 1;
 }
 
+// -------------------------
+// 扇出区间 (指向 CSR 数组的一段，只读)
+// -------------------------
+struct FanoutRange {
+    const AigId* first = nullptr;
+    const AigId* last = nullptr;
+
+    const AigId* begin() const { return first; }
+    const AigId* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// -------------------------
+// 并发构造时每个线程持有的一段 ID
+// -------------------------
+struct AigIdChunk {
+    AigId next = 0;
+    AigId end = 0;
+};
+
+struct ConcurrentBuild;
+
+// -------------------------
+// 统计信息 (与 print_stats 的输出一一对应)
+// -------------------------
+struct AigStats {
+    size_t pis = 0;
+    size_t pos = 0;
+    size_t area = 0;
+    uint32_t depth = 0;
+    size_t inverters = 0;
+};
+
+// 按 print_stats 的格式输出一行统计
+void print_stats(const AigStats& s);
+
+// -------------------------
+// compact() 的节点排列方式
+// -------------------------
+enum class AigOrder {
+    Dfs,        // 从输出做后序 DFS：节点紧跟在它最后一个 fanin 锥之后
+    Level,      // 按层级从低到高，同层内保持 DFS 的先后
+};
+
+// -------------------------
+// 组合优化的目标：加权和越小越好，相等时依次比较 area / depth / not
+// -------------------------
+struct AigObjective {
+    double area = 1;
+    double depth = 0;
+    double inverters = 0;
+
+    // "area" | "depth" | "not" | "mix" (三者等权) | "mix:wa,wd,wn"
+    static AigObjective parse(const std::string& spec);
+    double score(const AigStats& s) const;
+    bool better(const AigStats& a, const AigStats& b) const;   // a 是否严格优于 b
+};
+
+// -------------------------
+// 图的可选功能 (编译期)
+// -------------------------
+// AigGraphT<Features> 按 Features 里的开关决定 addAnd / addOutput 维护哪些簿记，
+// 关掉的功能在编译期整段去掉：
+//   kStrash:    addAnd 查 strash 去重并登记新节点 (关掉后每次都新建节点，
+//               hasAnd / lookupAnd 总是查不到)
+//   kFanouts:   扇出索引建好之后增量记录新边 (关掉后加节点直接把索引弄脏，
+//               fanouts() 用到时整体重建)
+//   kRefCounts: replace() 建立引用计数之后由 addAnd / addOutput 增量维护，
+//               addAnd 复用死节点槽位
+// AigGraph 是全部打开的默认实例，所有 pass 都只为它实例化；
+// AigPlainGraph 全部关掉，只实例化建图、深度、统计和仿真 (见各 .cpp 末尾的显式实例化)，
+// 适合只读一遍文件做统计的场合。它不合并重复的 AND，统计的是文件里写的门，
+// 文件有重复门时 area 比 AigGraph 读入后的大 (例如 01-adder 是 4，AigGraph 是 3)
+struct AigFullFeatures {
+    static constexpr bool kStrash = true;
+    static constexpr bool kFanouts = true;
+    static constexpr bool kRefCounts = true;
+};
+
+struct AigPlainFeatures {
+    static constexpr bool kStrash = false;
+    static constexpr bool kFanouts = false;
+    static constexpr bool kRefCounts = false;
+};
+
 // -------------------------
 // AIG 图
 // -------------------------
-class AigGraph {
+template <class Features>
+class AigGraphT {
 public:
-    std::vector<AigNode> nodes;
-    std::vector<uint32_t> inputs;
-    std::vector<uint32_t> outputs;
+    NodeStore nodes;           // 写时复制：复制 AigGraph 不复制节点
+    std::vector<AigId> inputs;
+    std::vector<AigLit> outputs;
 
 public:
     // 构造函数
-    AigGraph();
+    AigGraphT();
+
+    // 复制只共享节点块和 strash 的只读部分，与图的大小无关；
+    // 遍历标记、扇出索引等缓存不复制，副本第一次用到时自己建
+    AigGraphT(const AigGraphT& o);
+    AigGraphT& operator=(const AigGraphT& o);
+    AigGraphT(AigGraphT&&) = default;
+    AigGraphT& operator=(AigGraphT&&) = default;
 
     // 节点创建
-    uint32_t addInput();
-    uint32_t addAnd(uint32_t lit0, uint32_t lit1); // 如果输入非法，会抛异常
-    void addOutput(uint32_t lit);                  // 如果 lit 对应节点不存在，会抛异常
+    AigId addInput();
+    AigLit addAnd(AigLit lit0, AigLit lit1);   // 如果输入非法，会抛异常
+    void addOutput(AigLit lit);                // 如果 lit 对应节点不存在，会抛异常
+
+    // 批量建 AND：out[k] 与依次调用 addAnd(pairs[k].first, pairs[k].second) 的结果相同。
+    // refs[k] 的 bit 0 / bit 1 置位时，first / second 不是图里的字面量，而是
+    // make_lit(j, inv)：引用本批中更早 (j < k) 的结果 out[j] (inv 时取反)。
+    // 标记放在字面量之外，字面量的整个取值范围都可用。
+    // 两个操作数都已确定的对先一起查 strash，再按顺序建节点 (见 aig.cpp)
+    void addAndBatch(const std::vector<std::pair<AigLit, AigLit>>& pairs, const std::vector<uint8_t>& refs,
+                     std::vector<AigLit>& out);
+
+    // 可信输入的批量装载：按顺序追加 AND 节点 k = (fanin0[k], fanin1[k])，不查 strash、
+    // 不做常量折叠，只检查 fanin 非常量、互不相同且在节点之前 (不满足时抛
+    // std::invalid_argument)。输入应当已经 strash 过，重复的 AND 不会被合并。
+    // strash 延迟到第一次用到时 (addAnd / lookupAnd / replace / 并发构造等) 整体建立，
+    // 只读统计的流程完全不建；optimize() 自己重建 strash，也不会多建一次
+    void bulkLoad(const std::vector<AigLit>& fanin0, const std::vector<AigLit>& fanin1);
+
+    // 二进制快照 (格式见 snapshot.cpp)：节点块按内存里的排列原样写出；
+    // loadSnapshot 把文件只读 mmap 进来直接当作节点块，不做解析，只对每个
+    // 节点做 bulkLoad 同样的 O(1) 检查，之后写到哪一块才复制哪一块。
+    // 只能由字面量宽度和节点排列相同的构建读回。
+    // strash 不存，读回后第一次用到时重建 (同 bulkLoad)。
+    // 文件打不开、格式或版本不符、内容损坏时抛 std::runtime_error；
+    // 图里有死节点或 ID 不是拓扑序时 saveSnapshot 抛 std::logic_error (先 reclaim())
+    void saveSnapshot(const std::string& path) const;
+    void loadSnapshot(const std::string& path);
+    static bool isSnapshot(const std::string& path);      // 文件是否以快照的魔数开头
+
+    // 原地改写节点的 fanin (不做 strash 和扇出改写，改写节点请用 replace())；
+    // 在事务中会记入撤销日志
+    void setFanins(AigId id, AigLit lit0, AigLit lit1);
+
+    // 事务：begin 之后对 fanin 的改写 (setFanins / replace)、新增节点/输入/输出、
+    // strash 的插入和删除都记入撤销日志，rollback 按 O(改动量) 逆序恢复，
+    // 引用计数、空闲表和扇出索引随日志一起恢复，不整体重建
+    // (事务中途有操作弄脏了它们时除外，例如 setFanins / addInput)。
+    // commit 丢弃日志。不支持嵌套；事务中不能 optimize() 或并发构造
+    // (它们整体重建图，无法按条撤销)，否则抛 std::logic_error
+    void beginTransaction();
+    void commitTransaction();
+    void rollbackTransaction();
+    bool inTransaction() const { return txn_active; }
+
+    // 并行度：>1 时支持并行的 pass 通过 ThreadPool::global() 分块执行
+    void setThreads(unsigned n) { num_threads = n ? n : 1; }
+    unsigned threads() const { return num_threads; }
+
+    // 并发构造：beginConcurrent 为至多 max_threads 个线程预留 max_new_nodes 个
+    // 节点位置并把现有 strash 装进无锁表；之后这些线程可同时 addAndConcurrent (每个线程自带一个
+    // AigIdChunk，按块领取 ID，不锁 nodes)。同一 fanin 对总是得到同一个字面量。
+    // endConcurrent 压缩各块用剩的空洞并按拓扑序给新节点重新编号，同步改写 lits 里的字面量。
+    // 期间不能调用其它修改图的接口
+    void beginConcurrent(size_t max_new_nodes, unsigned max_threads);
+    AigLit addAndConcurrent(AigLit lit0, AigLit lit1, AigIdChunk& chunk);
+    void endConcurrent(std::vector<AigLit>& lits);
 
     // 深度计算
     uint32_t depth() const;
@@ -55,24 +218,189 @@ public:
     // 全局优化（去重 + 常量传播）
     void optimize();
 
+    // 分层版本：活节点按层级分组，逐层并行 strash；节点顺序只取决于图本身，
+    // 与线程数无关。setLevelizedOptimize(true) 后 optimize() 改走这条路径
+    void optimizeLevelized();
+    void setLevelizedOptimize(bool on) { levelized_opt = on; }
+
     // 重写
     void rewrite_phase1();
     void rewrite_phase2();
     void rewrite();
-    bool hasAnd(uint32_t lit0, uint32_t lit1) const;
+
+    // 按输出锥把每个 AND 分给唯一的一组 (按各组独占的 AND 数切成 parts 组)，跨组引用的
+    // 节点作为子 AIG 的边界输入/输出；各组并行 rewrite() 后按序拼回再 optimize()，
+    // 结果比输入大就退回普通的 rewrite()
+    void rewritePartitioned(unsigned parts);
+
+    // 按脚本执行一串 pass，以 ';' 分隔，例如 "rw*3;rf"
+    //   rw = 一轮 rewrite (phase1; optimize; phase2)   p1 / p2 = 单独的 phase
+    //   rf = refactor   opt = optimize   <step>*k = 重复 k 次
+    // 最后总会做一次相位分配；脚本不合法时抛 std::invalid_argument
+    // "rw*3" 与 rewrite() 完全相同
+    void runScript(const std::string& script);
+
+    // 组合优化：每个脚本在一个副本上执行 (副本之间并行)，保留目标最优的结果，
+    // 返回胜出脚本的下标
+    size_t optimizePortfolio(const std::vector<std::string>& scripts, const AigObjective& obj);
+    static const std::vector<std::string>& defaultScripts();
+    bool hasAnd(AigLit lit0, AigLit lit1) const;
+    AigLit lookupAnd(AigLit lit0, AigLit lit1) const; // 不存在时返回 kAigNone
     std::vector<int> build_refs() const;
+    void build_refs(std::vector<int>& refs) const;  // 复用调用方的缓冲区
+
+    // 相位分配：为每个 AND 选择正相/反相实现，使反相器最少
+    // (只改物理极性，不改逻辑；optimize() 重建后相位清零，应作为流程最后一步)
+    void assignPhases();
+
+    // 重构：大割集折叠为 ISOP 后因式分解重建
+    void refactor();
+
+    // 用 lit 替换节点 id：扇出和 PO 改指 lit，受影响的扇出重新 strash，
+    // 沿途变成常量/平凡的节点和与现有节点重复的节点继续向下游替换 (局部工作，
+    // 不需要 optimize())。被替换掉的节点和因此失去全部引用的锥 (MFFC)
+    // 成为死节点：从 strash 摘掉，fanin 清成 (0, 0)，槽位进入空闲表。
+    // lit 的锥里不能含有 id 本身 (否则成环)；在事务中可以整体回滚
+    void replace(AigId id, AigLit lit);
+    static bool isDeadNode(const AigNode& n) { return !n.is_input && n.fanin0 == 0 && n.fanin1 == 0; }
+
+    // 死节点回收 (见 reclaim.cpp)：引用计数在第一次 replace() 时建立，之后由
+    // addAnd / addOutput / replace 增量维护。空闲表非空时 addAnd 优先复用
+    // 死节点的槽位 (事务中除外)，此后 ID 不再保证拓扑序。
+    // reclaim() 在死节点占比达到 min_dead_fraction、或 ID 已不是拓扑序时
+    // 挤掉死槽位，按后序 DFS 重新编号 (同 compact(AigOrder::Dfs))，ID 恢复
+    // 拓扑序；返回是否重新编号，编号变化后调用方持有的 ID 全部失效
+    size_t deadCount() const;
+    bool reclaim(double min_dead_fraction = 0.5);
+
+    // 按 order 重新编号：常量 0、输入 (原顺序) 在前，AND 按指定顺序排在后面，
+    // 所有字面量和 strash 同步改写，死节点一并去掉。结构不变 (不做 strash 合并)，
+    // 只改善遍历时的访存局部性；编号变化后调用方持有的 ID 全部失效
+    void compact(AigOrder order);
+
+    // 64 路并行仿真：input_words[k] 是 inputs[k] 的 64 个样本，
+    // values[id] 返回节点 id 的样本。按 ID 顺序求值，要求 ID 是拓扑序
+    // (optimize() / compact() / reclaim() 之后成立，addAnd 复用死节点槽位之后
+    // 不一定)；遇到 fanin 的 ID 不小于自身时抛 std::logic_error
+    void simulate(const std::vector<uint64_t>& input_words, std::vector<uint64_t>& values) const;
+
+    // 重汇聚驱动的割集/窗口：从 root 出发，每次展开使叶子数增加最少的叶子
+    // leaves 返回叶子 ID，cone 返回锥内节点 (拓扑序，root 在最后)
+    void reconvCut(AigId root, uint32_t max_leaves, uint32_t max_cone,
+                   std::vector<AigId>& leaves, std::vector<AigId>& cone) const;
+
+    // 扇出索引 (CSR)：按需用两遍线性扫描构建，返回扇出节点 ID (不含 PO)
+    // 图被修改后索引变脏，下次查询时重建；直接改写 nodes 的代码
+    // 必须调用 invalidateFanouts() (引用计数随之失效，用到时再重建)
+    // addAnd / replace 不弄脏索引，只把新边记到溢出表里 (见 replace.cpp)；
+    // fanouts() 返回连续区间，有溢出边时会先整体重建
+    FanoutRange fanouts(AigId id) const;
+    uint32_t fanoutCount(AigId id) const { return static_cast<uint32_t>(fanouts(id).size()); }
+    void invalidateFanouts() { fanout_dirty = true; refs_tracked = false; txn_incremental = false; }
+
+    // 遍历标记：每次遍历前 incTravId()，O(1) 清空所有标记
+    // travData(id) 是每个节点一个随遍历复用的数据槽，只在该节点被
+    // 当前遍历标记过时有效 (例如 depth() 的层级、optimize() 的新字面量)
+    void incTravId() const;
+    void setTravIdCurrent(AigId id) const {
+        if (id >= trav_ids.size()) growTrav();
+        trav_ids[id] = trav_id_cur;
+    }
+    bool isTravIdCurrent(AigId id) const {
+        return id < trav_ids.size() && trav_ids[id] == trav_id_cur;
+    }
+    AigLit& travData(AigId id) const {
+        assert(isTravIdCurrent(id));
+        return trav_data[id];
+    }
 
     // 统计信息
+    AigStats stats() const;
     void print_stats() const;  // 输出格式: pis=2, pos=2, area=4, depth=2, not=4
 
 private:
-    uint32_t depthRec(uint32_t id, std::vector<int>& memo) const;
-    uint32_t countAnds() const;
-    uint32_t countInverters() const;
-    std::unordered_map<uint64_t, uint32_t> computed_table;
+    uint32_t depthRec(AigId id) const;
+    void growTrav() const;
+    void buildFanouts() const;
+    size_t countAnds() const;
+    size_t countInverters() const;
+    mutable StrashTable computed_table;    // 各副本共享只读部分；bulkLoad 之后延迟建立
+    mutable bool strash_stale = false;      // computed_table 还缺 bulkLoad 装入的节点
+    void ensureStrash() const {
+        if constexpr (Features::kStrash)
+            if (strash_stale) buildStrash();
+    }
+    void buildStrash() const;
+    unsigned num_threads = 1;
+    std::shared_ptr<ConcurrentBuild> conc;    // 只在 begin/endConcurrent 之间存在
+    bool levelized_opt = false;
+
+    mutable std::vector<AigId> fanout_start;   // 节点 i 的扇出位于 [start[i], start[i+1])
+    mutable std::vector<AigId> fanout_ids;
+    mutable bool fanout_dirty = true;
+    // CSR 建好之后新增的边 (节点 -> 扇出节点 / PO 下标)，读取时按当前 fanin 校验
+    mutable std::unordered_map<AigId, std::vector<AigId>> fanout_extra;
+    mutable std::unordered_map<AigId, std::vector<AigId>> output_refs;
+    void addFanoutEdge(AigId from, AigId to) const;
+    void collectFanouts(AigId id, std::vector<AigId>& out) const;
+    void collectOutputs(AigId id, std::vector<AigId>& out) const;
+    void relink(AigId id, AigLit lit0, AigLit lit1);
+    void setOutput(size_t index, AigLit lit);
+
+    // 引用计数 (AND 扇出 + PO)，refs_tracked 为 false 时不维护
+    std::vector<AigId> ref_count;
+    std::vector<AigId> free_ids;       // 死节点槽位，后进先出
+    std::vector<AigId> ref_zero;       // 引用刚降到 0、等待 deleteUnreferenced 处理的节点
+    bool refs_tracked = false;
+    void buildRefCounts();
+    void refInc(AigLit lit) { if (lit_id(lit)) ++ref_count[lit_id(lit)]; }
+    void refDec(AigLit lit) {
+        AigId id = lit_id(lit);
+        if (id && --ref_count[id] == 0) ref_zero.push_back(id);
+    }
+    void unhashNode(AigId id);
+    void deleteUnreferenced();
+    void renumber(const std::vector<AigId>& order);
+    // 从输出、再从其余活的 AND 出发的非递归后序 DFS：post 按拓扑序列出所有
+    // 活的 AND (与 ID 顺序无关)，返回最大层级；之后 travData(id) 是节点的层级
+    AigLit topoOrder(std::vector<AigId>& post) const;
+
+    mutable std::vector<uint32_t> trav_ids;   // 每个节点最近一次被标记时的遍历 ID
+    mutable std::vector<AigLit> trav_data;    // 与 trav_ids 对应的数据槽 (存 ID / 字面量 / 层级)
+    mutable uint32_t trav_id_cur = 0;
+    mutable std::vector<std::pair<AigId, bool>> trav_stack;  // 非递归 DFS 复用的栈
+
+    // 撤销日志
+    struct UndoEntry {
+        enum Kind : uint8_t { Fanins, StrashInsert, StrashErase, Output } kind;
+        AigLit id;          // Fanins: 节点；StrashErase: 被删掉的字面量；Output: PO 下标
+        AigLit fanin0, fanin1;
+        AigKey key;
+    };
+    void strashInsert(const AigKey& key, AigLit lit);
+    void strashErase(const AigKey& key);
+    bool txn_active = false;
+    size_t txn_nodes = 0, txn_inputs = 0, txn_outputs = 0, txn_free = 0;
+    bool txn_refs = false;          // 事务开始时引用计数是否有效
+    bool txn_fanouts = false;       // 事务开始时扇出索引是否有效
+    bool txn_incremental = false;   // 事务中没有 invalidateFanouts()，可以按日志恢复它们
+    std::vector<UndoEntry> undo_log;
 };
-    
+
+using AigGraph = AigGraphT<AigFullFeatures>;
+using AigPlainGraph = AigGraphT<AigPlainFeatures>;
+
 // -------------------------
 // AIGER 文件读取
 // -------------------------
-bool read_aiger_file(const std::string& filename, AigGraph& aig);
+// trusted: 文件来自已经 strash 过的工具且按标准编号 (输入、latch、AND 依次编号)，
+// AIGER 字面量直接当作内部字面量，AND 经 bulkLoad 装入；编号不符时报错返回 false
+// parse_threads: 0 时逐个从流里读 AND 段；否则映射文件，用这么多线程并行解码
+// AND 段的文本，字面量映射和 strash 仍然顺序做，结果与逐个读相同
+template <class F>
+bool read_aiger_file(const std::string& filename, AigGraphT<F>& aig, bool trusted = false,
+                     unsigned parse_threads = 0);
+
+// 只统计不建图：边读 AND 段边算 pis / pos / area / depth / not，
+// 结果与读进 AigPlainGraph 后的 stats() 相同，内存只有每个变量的层级和一个位
+bool stream_aiger_stats(const std::string& filename, AigStats& stats);
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// -------------------------
+// 字面量 / 节点 ID / strash 键的整数类型
+// -------------------------
+// 字面量 = ID << 1 | 反相位。默认 32 位，节点数上限约 2^31；
+// CMake 选项 AIG_LIT64 打开后改为 64 位。strash 键由一对有序字面量组成：
+// 32 位时打包成一个 uint64_t (lit0 << 32 | lit1)，64 位时是两个字的结构体。
+// 默认构建的类型和键的打包方式都不变，32 位用户没有额外开销。
+#ifdef AIG_LIT64
+using AigLit = uint64_t;
+
+struct AigKey {
+    uint64_t lit0 = 0;
+    uint64_t lit1 = 0;
+    bool operator==(const AigKey& o) const { return lit0 == o.lit0 && lit1 == o.lit1; }
+    bool operator!=(const AigKey& o) const { return !(*this == o); }
+};
+
+struct AigKeyHash {
+    size_t operator()(const AigKey& k) const {
+        return std::hash<uint64_t>()((k.lit0 * 0x9E3779B97F4A7C15ULL) ^ k.lit1);
+    }
+};
+
+static inline AigKey strash_key(AigLit lit0, AigLit lit1) { return AigKey{lit0, lit1}; }
+static inline AigLit key_lit0(const AigKey& k) { return k.lit0; }
+static inline AigLit key_lit1(const AigKey& k) { return k.lit1; }
+#else
+using AigLit = uint32_t;
+using AigKey = uint64_t;
+using AigKeyHash = std::hash<uint64_t>;
+
+static inline AigKey strash_key(AigLit lit0, AigLit lit1) {
+    return (static_cast<uint64_t>(lit0) << 32) | lit1;
+}
+static inline AigLit key_lit0(AigKey k) { return static_cast<AigLit>(k >> 32); }
+static inline AigLit key_lit1(AigKey k) { return static_cast<AigLit>(k); }
+#endif
+
+using AigId = AigLit;                       // 节点 ID 与字面量同宽
+static constexpr AigLit kAigNone = ~AigLit(0);  // "没有" 字面量 / ID
@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "aig_types.h"
+
+// -------------------------
+// 并发结构哈希表 (无锁，开放寻址)
+// -------------------------
+// 键是 fanin 对 (lit0 < lit1，因此 lit1 永远非 0)，0 表示空槽。插入键用 CAS
+// 抢占空槽，线性探测，不支持删除和扩容，容量在构造时按预期元素数一次定好。
+// 32 位字面量时键打包成一个 64 位字，一次 CAS 完成；AIG_LIT64 时键占两个字：
+// 先把 lit1 字从 0 CAS 成 kBusy 占住槽，写好 lit0 字后再发布 lit1，
+// 其他线程看到 kBusy 就等一下再比较。
+//
+// 每个槽的值是一个 64 位原子量，只能通过 fetchMin 变小：
+//   - 最终字面量 (< kClaimTag)
+//   - 认领标记 kClaimTag | 序号，同一键多个认领者中序号最小的胜出
+//   - kEmptyValue (尚无值)
+// 最终值总是小于任何认领标记，所以写入最终值后不会再被覆盖。
+//
+// 两种用法：
+//   - 确定性认领 (optimizeLevelized)：fetchMin(kClaimTag | 序号) 选出胜者
+//   - 先到先得 (addAndConcurrent)：插入键的线程建节点后发布字面量，
+//     其他线程 wait() 到值出现，同一 fanin 对总是得到同一个字面量
+class ConcurrentStrash {
+public:
+    static constexpr uint64_t kEmptyValue = UINT64_MAX;
+    static constexpr uint64_t kClaimTag = sizeof(AigLit) == 4 ? 1ULL << 32 : 1ULL << 63;
+
+    explicit ConcurrentStrash(size_t expected) {
+        size_t cap = 16;
+        int bits = 4;
+        while (cap < expected * 2) { cap <<= 1; ++bits; }
+        mask = cap - 1;
+        shift = 64 - bits;
+        keys.reset(new std::atomic<uint64_t>[cap]);
+        vals.reset(new std::atomic<uint64_t>[cap]);
+        for (size_t i = 0; i < cap; ++i) {
+            keys[i].store(0, std::memory_order_relaxed);
+            vals[i].store(kEmptyValue, std::memory_order_relaxed);
+        }
+#ifdef AIG_LIT64
+        keys_hi.reset(new std::atomic<uint64_t>[cap]);
+        for (size_t i = 0; i < cap; ++i) keys_hi[i].store(0, std::memory_order_relaxed);
+#endif
+    }
+
+    static AigKey makeKey(AigLit lit0, AigLit lit1) { return strash_key(lit0, lit1); }
+
+#ifdef AIG_LIT64
+    // 找到或插入 key 所在的槽；inserted 表示键是不是本线程插入的
+    size_t slot(const AigKey& key, bool& inserted) {
+        size_t h = hash(key);
+        inserted = false;
+        for (;;) {
+            uint64_t k = keys[h].load(std::memory_order_acquire);
+            if (k == kBusy) continue;
+            if (k == key.lit1 && keys_hi[h].load(std::memory_order_relaxed) == key.lit0) return h;
+            if (k == 0) {
+                uint64_t expected = 0;
+                if (keys[h].compare_exchange_strong(expected, kBusy, std::memory_order_acq_rel)) {
+                    keys_hi[h].store(key.lit0, std::memory_order_relaxed);
+                    keys[h].store(key.lit1, std::memory_order_release);
+                    inserted = true;
+                    return h;
+                }
+                continue;   // 被别人占了，重新看这个槽
+            }
+            h = (h + 1) & mask;
+        }
+    }
+#else
+    // 找到或插入 key 所在的槽；inserted 表示键是不是本线程插入的
+    size_t slot(AigKey key, bool& inserted) {
+        size_t h = hash(key);
+        inserted = false;
+        for (;;) {
+            uint64_t k = keys[h].load(std::memory_order_acquire);
+            if (k == key) return h;
+            if (k == 0) {
+                uint64_t expected = 0;
+                if (keys[h].compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+                    inserted = true;
+                    return h;
+                }
+                if (expected == key) return h;
+            }
+            h = (h + 1) & mask;
+        }
+    }
+#endif
+
+    size_t slot(const AigKey& key) {
+        bool inserted;
+        return slot(key, inserted);
+    }
+
+    // 等待插入者发布值 (插入键和写值之间只隔着建节点的几条指令)
+    uint64_t wait(size_t s) const {
+        uint64_t v;
+        while ((v = vals[s].load(std::memory_order_acquire)) == kEmptyValue) {}
+        return v;
+    }
+
+    // 只查找，不存在时返回 kEmptyValue
+    uint64_t find(const AigKey& key) const {
+        size_t h = hash(key);
+        for (;;) {
+            uint64_t k = keys[h].load(std::memory_order_acquire);
+#ifdef AIG_LIT64
+            if (k == kBusy) continue;
+            if (k == key.lit1 && keys_hi[h].load(std::memory_order_relaxed) == key.lit0)
+#else
+            if (k == key)
+#endif
+                return vals[h].load(std::memory_order_acquire);
+            if (k == 0) return kEmptyValue;
+            h = (h + 1) & mask;
+        }
+    }
+
+    // 原子地把槽的值改成 min(旧值, v)，返回改后的值
+    uint64_t fetchMin(size_t s, uint64_t v) {
+        uint64_t cur = vals[s].load(std::memory_order_acquire);
+        while (v < cur && !vals[s].compare_exchange_weak(cur, v, std::memory_order_acq_rel)) {}
+        return v < cur ? v : cur;
+    }
+
+    uint64_t value(size_t s) const { return vals[s].load(std::memory_order_acquire); }
+
+private:
+    // Fibonacci 散列，取乘积的高位
+#ifdef AIG_LIT64
+    size_t hash(const AigKey& key) const {
+        uint64_t x = (key.lit0 * 0x9E3779B97F4A7C15ULL) ^ key.lit1;
+        return static_cast<size_t>((x * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+    static constexpr uint64_t kBusy = UINT64_MAX;   // 槽已被占、lit0 字还没写好
+#else
+    size_t hash(AigKey key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+#endif
+
+    size_t mask;
+    int shift;
+    std::unique_ptr<std::atomic<uint64_t>[]> keys;      // 32 位：整个键；64 位：lit1
+    std::unique_ptr<std::atomic<uint64_t>[]> vals;
+#ifdef AIG_LIT64
+    std::unique_ptr<std::atomic<uint64_t>[]> keys_hi;   // lit0
+#endif
+};
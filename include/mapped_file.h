@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// -------------------------
+// 整个文件的只读映射
+// -------------------------
+// open 失败 (打不开、空文件、映射失败) 时返回 false。析构时解除映射，
+// 需要让映射活得比创建者久时用 shared_ptr 持有。
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (addr != MAP_FAILED) munmap(addr, len);
+    }
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            len = static_cast<size_t>(st.st_size);
+            addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        return addr != MAP_FAILED;
+    }
+
+    const char* data() const { return static_cast<const char*>(addr); }
+    size_t size() const { return len; }
+
+private:
+    void* addr = MAP_FAILED;
+    size_t len = 0;
+};
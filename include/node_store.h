@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// -------------------------
+// 分块写时复制的节点存储
+// -------------------------
+// 节点按 kChunkSize 个一块存放，块由 shared_ptr 持有。复制 NodeStore 只复制
+// 块指针 (N / kChunkSize 个)，不复制节点；之后哪边先写某一块，哪边才复制那一块。
+// 接口保持 std::vector 的常用子集，nodes[id] 的写法不变。
+//
+// 块的 shared_ptr 只有本对象持有 (use_count() == 1) 时才原地写，否则先复制一份，
+// 所以被共享的块在谁手里都不会被原地修改。复制只增加块的引用计数，不改动源对象，
+// 多个线程可以同时复制同一个 const 存储；副本都销毁之后源对象又能原地写。
+// adopt 进来的外部块另有 external 标记，引用计数为 1 也要先复制。
+//
+// 注意非 const 的 operator[] 即使只读也会在块被共享时复制：
+// 并行循环里要么通过 const 引用访问，要么先 detach() 让所有块独占。
+//
+// 块内的排列由 Layout 决定：默认的 AosLayout 每个节点一个结构体，
+// operator[] 返回 Node&；SoaLayout (soa_layout.h) 按字段分成独立数组，
+// operator[] 返回代理对象。要写节点时用 auto&& 接住 operator[] 的结果，
+// 两种排列下写法相同。
+// (aig.h 里 NodeStore = ChunkedStore<AigNode> 或 ChunkedStore<AigNode, SoaLayout>)
+template <class Node, size_t N>
+struct AosLayout {
+    struct Chunk {
+        Node v[N];
+    };
+    using Ref = Node&;
+    using ConstRef = const Node&;
+    static Ref at(Chunk& c, size_t i) { return c.v[i]; }
+    static ConstRef at(const Chunk& c, size_t i) { return c.v[i]; }
+};
+
+template <class Node, template <class, size_t> class Layout = AosLayout>
+class ChunkedStore {
+public:
+    static constexpr unsigned kChunkBits = 12;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+    using L = Layout<Node, kChunkSize>;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    typename L::ConstRef operator[](size_t i) const { return L::at(*chunks[i >> kChunkBits], i & kMask); }
+    typename L::Ref operator[](size_t i) { return L::at(own(i >> kChunkBits), i & kMask); }
+
+    typename L::ConstRef back() const { return (*this)[count - 1]; }
+
+    ChunkedStore() = default;
+    ChunkedStore(const ChunkedStore& o) = default;
+    ChunkedStore(ChunkedStore&&) = default;
+    ChunkedStore& operator=(const ChunkedStore& o) = default;
+    ChunkedStore& operator=(ChunkedStore&&) = default;
+
+    void push_back(const Node& n) {
+        if (count == chunks.size() * kChunkSize) {
+            chunks.push_back(std::make_shared<Chunk>());
+            external.push_back(0);
+        }
+        (*this)[count++] = n;
+    }
+
+    void resize(size_t n, const Node& fill = Node()) {
+        size_t old = chunks.size();
+        chunks.resize((n + kChunkSize - 1) >> kChunkBits);
+        external.resize(chunks.size(), 0);
+        for (size_t c = old; c < chunks.size(); ++c) chunks[c] = std::make_shared<Chunk>();
+        for (size_t i = count; i < n; ++i) (*this)[i] = fill;
+        count = n;
+    }
+
+    void clear() {
+        chunks.clear();
+        external.clear();
+        count = 0;
+    }
+
+    void swap(ChunkedStore& o) noexcept {
+        chunks.swap(o.chunks);
+        external.swap(o.external);
+        std::swap(count, o.count);
+    }
+
+    // 让所有块都归本对象独占
+    void detach() {
+        for (size_t c = 0; c < chunks.size(); ++c) own(c);
+    }
+
+    // 还没有独占的块数 (调试和统计用)
+    size_t sharedChunks() const {
+        size_t n = 0;
+        for (size_t c = 0; c < chunks.size(); ++c) n += !writable(c);
+        return n;
+    }
+
+    // 块的原始字节 (快照读写用)：kChunkBytes 字节，就是块在内存里的排列。
+    // adopt 让存储直接引用外部的 n 个节点 (比如 mmap 进来的只读文件)，owner 负责
+    // 让那段内存活得足够久；这些块标成 external，写之前照常先复制，不会写到外部内存
+    using Chunk = typename L::Chunk;
+    static constexpr size_t kChunkBytes = sizeof(Chunk);
+    size_t chunkCount() const { return chunks.size(); }
+    const void* chunkData(size_t c) const { return chunks[c].get(); }
+    void adopt(const std::shared_ptr<const void>& owner, const void* data, size_t n) {
+        const Chunk* first = static_cast<const Chunk*>(data);
+        chunks.resize((n + kChunkSize - 1) >> kChunkBits);
+        external.assign(chunks.size(), 1);
+        for (size_t c = 0; c < chunks.size(); ++c)
+            chunks[c] = std::shared_ptr<Chunk>(owner, const_cast<Chunk*>(first + c));
+        count = n;
+    }
+
+private:
+    static constexpr size_t kMask = kChunkSize - 1;
+
+    bool writable(size_t c) const { return !external[c] && chunks[c].use_count() == 1; }
+
+    Chunk& own(size_t c) {
+        if (!writable(c)) {
+            chunks[c] = std::make_shared<Chunk>(*chunks[c]);
+            external[c] = 0;
+        }
+        return *chunks[c];
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    std::vector<char> external;     // adopt 进来的块 (指向外部内存，不能原地写)
+    size_t count = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// -------------------------
+// 按字段分数组的节点排列 (structure-of-arrays)
+// -------------------------
+// 供 ChunkedStore 使用：每块里 fanin0 / fanin1 各是一个 64 字节对齐的数组，
+// is_input / phase 压成位图。计数、仿真、层级扫描这类只读一两个字段的
+// 整图循环只会读到用得上的数组，连续访存，也便于编译器向量化。
+// Node 需要有 fanin0 / fanin1 (整数) 和 is_input / phase (bool) 四个字段。
+//
+// operator[] 返回代理：字段可以照常读写 (nodes[id].fanin0 = x)，
+// 也能整体赋值或转换成 Node 的副本。注意：
+//   - const AigNode& n = nodes[id] 得到的是副本，之后对 nodes[id] 的写入看不到
+//   - 同一个 64 位字里的 is_input / phase 不能在多个线程里同时写；
+//     并行循环只写 fanin，位标记在串行阶段设好
+template <class Node, size_t N>
+struct SoaLayout {
+    static_assert(N % 64 == 0, "chunk size must be a multiple of 64");
+
+    using Lit = decltype(Node::fanin0);
+
+    struct Chunk {
+        alignas(64) Lit fanin0[N];
+        alignas(64) Lit fanin1[N];
+        alignas(64) uint64_t is_input[N / 64];
+        uint64_t phase[N / 64];
+    };
+
+    class BitRef {
+    public:
+        BitRef(uint64_t* w, uint64_t m) : word(w), mask(m) {}
+        BitRef(const BitRef&) = default;
+        operator bool() const { return (*word & mask) != 0; }
+        // 写的是指向的位，不是 BitRef 本身，所以是 const
+        const BitRef& operator=(bool b) const {
+            if (b) *word |= mask;
+            else *word &= ~mask;
+            return *this;
+        }
+        const BitRef& operator=(const BitRef& o) const { return *this = static_cast<bool>(o); }
+
+    private:
+        uint64_t* word;
+        uint64_t mask;
+    };
+
+    struct Ref {
+        Lit& fanin0;
+        Lit& fanin1;
+        BitRef is_input;
+        BitRef phase;
+
+        Ref(const Ref&) = default;
+        operator Node() const {
+            Node n;
+            n.fanin0 = fanin0;
+            n.fanin1 = fanin1;
+            n.is_input = is_input;
+            n.phase = phase;
+            return n;
+        }
+        const Ref& operator=(const Node& n) const {
+            fanin0 = n.fanin0;
+            fanin1 = n.fanin1;
+            is_input = n.is_input;
+            phase = n.phase;
+            return *this;
+        }
+        const Ref& operator=(const Ref& o) const { return *this = static_cast<Node>(o); }
+    };
+    using ConstRef = Node;
+
+    static Ref at(Chunk& c, size_t i) {
+        uint64_t m = uint64_t(1) << (i & 63);
+        return Ref{c.fanin0[i], c.fanin1[i], BitRef(&c.is_input[i >> 6], m), BitRef(&c.phase[i >> 6], m)};
+    }
+    static ConstRef at(const Chunk& c, size_t i) {
+        Node n;
+        n.fanin0 = c.fanin0[i];
+        n.fanin1 = c.fanin1[i];
+        n.is_input = (c.is_input[i >> 6] >> (i & 63)) & 1;
+        n.phase = (c.phase[i >> 6] >> (i & 63)) & 1;
+        return n;
+    }
+};
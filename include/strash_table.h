@@ -0,0 +1,144 @@
+#pragma once
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "aig_types.h"
+
+// -------------------------
+// 可共享的结构哈希表
+// -------------------------
+// 由若干层组成：top 是本对象正在写的一层，next 依次指向更早的只读层，
+// 删除记为墓碑。查找从 top 往下，第一层命中的记录为准。
+// 复制只共享 top 指针，不改动源对象，所以复制是 O(1)，多个线程可以同时
+// 复制同一个 const 表。写之前看 top 是否只有本对象持有 (use_count() == 1)：
+// 是就原地写，否则在它上面压一个新的空层 (O(1))，共享的层谁都不再修改。
+// 层数超过 kMaxDepth 时把上面较小的几层合并成一层，合并量与这些层的修改量
+// 成比例，不会每次都重建整张表。
+class StrashTable {
+public:
+    using Map = std::unordered_map<AigKey, AigLit, AigKeyHash>;
+    static constexpr AigLit kNone = kAigNone;
+
+    StrashTable() = default;
+    StrashTable(const StrashTable&) = default;
+    StrashTable(StrashTable&&) = default;
+    StrashTable& operator=(const StrashTable&) = default;
+    StrashTable& operator=(StrashTable&&) = default;
+
+    // 查找，不存在时返回 kNone
+    AigLit find(const AigKey& key) const {
+        for (const Layer* l = top.get(); l; l = l->next.get()) {
+            auto it = l->map.find(key);
+            if (it != l->map.end()) return it->second;
+        }
+        return kNone;
+    }
+
+    bool contains(const AigKey& key) const { return find(key) != kNone; }
+
+    // 预取 key 在最上面两层所在桶的第一个节点，不改变任何状态。
+    // 批量查找时提前若干个键调用，让这些缓存缺失与前面的查找重叠
+    void prefetch(const AigKey& key) const {
+        const Layer* l = top.get();
+        for (int k = 0; k < 2 && l; ++k, l = l->next.get()) prefetchIn(l->map, key);
+    }
+
+    void insert(const AigKey& key, AigLit lit) { writableTop().map[key] = lit; }
+
+    void erase(const AigKey& key) {
+        Layer& t = writableTop();
+        if (t.next && findIn(t.next.get(), key) != kNone) t.map[key] = kNone;
+        else t.map.erase(key);
+    }
+
+    void clear() { top.reset(); }
+
+    // 整体替换成 m (optimize 重建之后)，不复制
+    void assign(Map&& m) { top = std::make_shared<Layer>(std::move(m), nullptr); }
+
+    // 元素个数的上界 (墓碑和被覆盖的键会重复计数)
+    size_t sizeHint() const {
+        size_t n = 0;
+        for (const Layer* l = top.get(); l; l = l->next.get()) n += l->map.size();
+        return n;
+    }
+
+    // 遍历所有有效的 (key, lit)
+    template <class F>
+    void forEach(F&& fn) const {
+        for (const Layer* l = top.get(); l; l = l->next.get())
+            for (auto const& [key, lit] : l->map)
+                if (lit != kNone && !shadowed(l, key)) fn(key, lit);
+    }
+
+    // 层数 (调试和统计用)
+    size_t depth() const { return top ? top->depth + 1 : 0; }
+
+private:
+    static constexpr size_t kMaxDepth = 8;
+
+    struct Layer {
+        Layer(Map&& m, std::shared_ptr<const Layer> below)
+            : map(std::move(m)), next(std::move(below)), depth(next ? next->depth + 1 : 0) {}
+        Map map;                            // kNone 是墓碑
+        std::shared_ptr<const Layer> next;  // 更早的一层
+        size_t depth;                       // 下面还有几层
+    };
+
+    static AigLit findIn(const Layer* l, const AigKey& key) {
+        for (; l; l = l->next.get()) {
+            auto it = l->map.find(key);
+            if (it != l->map.end()) return it->second;
+        }
+        return kNone;
+    }
+
+    // key 是否已经在 l 上面的某一层里出现过
+    bool shadowed(const Layer* l, const AigKey& key) const {
+        for (const Layer* u = top.get(); u != l; u = u->next.get())
+            if (u->map.count(key)) return true;
+        return false;
+    }
+
+    static void prefetchIn(const Map& m, const AigKey& key) {
+        if (m.empty()) return;
+        size_t b = m.bucket(key);
+        auto it = m.begin(b);
+        if (it != m.end(b)) __builtin_prefetch(&*it);
+    }
+
+    Layer& writableTop() {
+        if (!top) top = std::make_shared<Layer>(Map(), nullptr);
+        else if (top.use_count() != 1) {
+            if (top->depth + 1 < kMaxDepth) top = std::make_shared<Layer>(Map(), std::move(top));
+            else top = mergeUpper();
+        }
+        return *top;
+    }
+
+    // 从 top 往下合并，直到下一层比已经合并的部分的两倍还大 (至少合并两层)；
+    // 合并到底时墓碑可以丢掉
+    std::shared_ptr<Layer> mergeUpper() const {
+        std::vector<const Layer*> upper;
+        size_t acc = 0;
+        const Layer* l = top.get();
+        while (l && (upper.size() < 2 || l->map.size() <= 2 * acc)) {
+            upper.push_back(l);
+            acc += l->map.size();
+            l = l->next.get();
+        }
+        const bool bottom = (l == nullptr);
+        Map merged;
+        merged.reserve(acc);
+        for (size_t k = upper.size(); k-- > 0;)
+            for (auto const& [key, lit] : upper[k]->map) {
+                if (bottom && lit == kNone) merged.erase(key);
+                else merged[key] = lit;
+            }
+        return std::make_shared<Layer>(std::move(merged), upper.back()->next);
+    }
+
+    std::shared_ptr<Layer> top;
+};
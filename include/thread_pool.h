@@ -0,0 +1,201 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+// -------------------------
+// 每个工作线程的临时内存区
+// -------------------------
+// 按块分配的 bump allocator：alloc 只移动指针，reset 后块留着复用。
+// 只适合平凡析构的类型，内存在 reset 之前一直有效。
+// 等待中的线程会在自己栈上嵌套执行偷来的任务，同一个 arena 可能有外层
+// 调用正在使用，所以各个 pass 用 Scope 只退回自己分配的部分，不 reset。
+class ScratchArena {
+public:
+    template <class T>
+    T* alloc(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena holds trivial types only");
+        return static_cast<T*>(raw(n * sizeof(T), alignof(T)));
+    }
+
+    void reset() { cur = 0; off = 0; }
+
+    // 分配位置的快照；rewind 释放快照之后分配的所有内存
+    struct Mark {
+        size_t cur, off;
+    };
+    Mark mark() const { return {cur, off}; }
+    void rewind(Mark m) { cur = m.cur; off = m.off; }
+
+    // 作用域结束 (包括异常退出) 时退回到进入时的位置
+    class Scope {
+    public:
+        explicit Scope(ScratchArena& a) : arena(a), saved(a.mark()) {}
+        ~Scope() { arena.rewind(saved); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ScratchArena& arena;
+        Mark saved;
+    };
+
+private:
+    void* raw(size_t bytes, size_t align);
+
+    static constexpr size_t kBlockSize = 1 << 20;
+    std::vector<std::unique_ptr<unsigned char[]>> blocks;
+    std::vector<size_t> sizes;
+    size_t cur = 0;     // 当前块
+    size_t off = 0;     // 当前块内偏移
+};
+
+// -------------------------
+// 工作窃取线程池
+// -------------------------
+// 进程内共享一个池 (ThreadPool::global())，各个 pass 通过 parallel_for /
+// parallel_reduce 使用，不各自创建线程。
+//
+// 每个线程有自己的任务队列：自己从尾部取 (LIFO，缓存友好)，空闲时从
+// 别人队列头部偷 (FIFO，偷到的是较大的任务)。等待中的线程会帮着执行
+// 其他任务，所以在任务里嵌套调用 parallel_for 不会死锁。
+// 编号 0 的队列由池外的线程 (通常是主线程) 共用，1..size()-1 是工作线程。
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 参与计算的线程数 (工作线程 + 调用线程)
+    unsigned size() const { return capacity; }
+
+    // 全局共享池，按硬件线程数配置；工作线程在第一次真正并行时才启动
+    static ThreadPool& global();
+
+    // 当前线程在本池中的编号，不属于本池的线程都是 0
+    unsigned workerIndex() const;
+
+    // 当前线程专属的临时内存区。工作线程用自己槽位里的，池外的线程
+    // (可能有好几个同时调用) 各用一个 thread_local 的，互不共享
+    ScratchArena& arena();
+
+    // 把 [begin, end) 切成大小为 grain 的块并行执行 fn(lo, hi)
+    // 至多 max_threads 个线程参与；块之间不保证执行顺序
+    template <class F>
+    void parallel_for(size_t begin, size_t end, size_t grain, unsigned max_threads, F&& fn);
+
+    // 确定性归约：块划分只取决于 grain，部分结果按块顺序合并，
+    // 因此结果与线程数和调度无关 (浮点等不满足结合律的情形也一样)
+    template <class T, class Map, class Combine>
+    T parallel_reduce(size_t begin, size_t end, size_t grain, unsigned max_threads,
+                      T identity, Map&& map, Combine&& combine);
+
+private:
+    using Task = std::function<void()>;
+
+    struct Slot {
+        std::mutex m;
+        std::deque<Task> q;
+        ScratchArena arena;
+    };
+
+    void push(Task task);           // 推入当前线程自己的队列
+    bool runOne(unsigned self);     // 执行一个任务：先自己的，再偷别人的
+    void wakeAll();                 // 唤醒睡着的工作线程和等待者
+
+    // 等待者没活可帮时先让出这么多次，之后睡在 sleep_cv 上
+    static constexpr unsigned kSpinLimit = 64;
+    void workerLoop(unsigned index);
+    void ensureStarted();
+
+    unsigned capacity;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+
+    std::mutex start_m;
+    std::mutex sleep_m;
+    std::condition_variable sleep_cv;
+    bool stopping = false;
+};
+
+template <class F>
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain, unsigned max_threads, F&& fn)
+{
+    if (begin >= end) return;
+    if (grain == 0) grain = 1;
+    const size_t nchunks = (end - begin + grain - 1) / grain;
+    unsigned helpers = std::min<unsigned>(max_threads, size());
+    helpers = helpers > 0 ? helpers - 1 : 0;
+    if (nchunks < helpers + 1) helpers = static_cast<unsigned>(nchunks - 1);
+
+    if (helpers == 0) {
+        fn(begin, end);
+        return;
+    }
+
+    // 块用原子计数器领取 (自调度)，帮手任务可以被任意空闲线程偷走。
+    // 没领到块的帮手直接返回，只通过 shared_ptr 访问状态，
+    // 不会碰到已经返回的 fn
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+    };
+    auto st = std::make_shared<State>();
+    auto run = [this, st, begin, end, grain, nchunks, &fn]() {
+        size_t c;
+        while ((c = st->next.fetch_add(1)) < nchunks) {
+            size_t lo = begin + c * grain;
+            size_t hi = std::min(end, lo + grain);
+            fn(lo, hi);
+            if (st->done.fetch_add(1) + 1 == nchunks) wakeAll();    // 最后一块：叫醒等待者
+        }
+    };
+
+    for (unsigned i = 0; i < helpers; ++i) push(run);
+    run();
+
+    // 等其他线程手里的块做完；等待期间帮忙执行别的任务，
+    // 连续 kSpinLimit 次没活可帮就睡下，直到做完或者又有新任务入队
+    const unsigned self = workerIndex();
+    for (unsigned idle = 0; st->done.load() < nchunks;) {
+        if (runOne(self)) {
+            idle = 0;
+        } else if (++idle < kSpinLimit) {
+            std::this_thread::yield();
+        } else {
+            std::unique_lock<std::mutex> lk(sleep_m);
+            sleep_cv.wait(lk, [&] { return st->done.load() >= nchunks || queued.load() > 0; });
+            idle = 0;
+        }
+    }
+}
+
+template <class T, class Map, class Combine>
+T ThreadPool::parallel_reduce(size_t begin, size_t end, size_t grain, unsigned max_threads,
+                              T identity, Map&& map, Combine&& combine)
+{
+    if (begin >= end) return identity;
+    if (grain == 0) grain = 1;
+    const size_t nchunks = (end - begin + grain - 1) / grain;
+    std::vector<T> partial(nchunks, identity);
+    parallel_for(0, nchunks, 1, max_threads, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; ++c) {
+            size_t b = begin + c * grain;
+            partial[c] = map(b, std::min(end, b + grain));
+        }
+    });
+    T acc = identity;
+    for (const T& p : partial) acc = combine(acc, p);
+    return acc;
+}
@@ -1,4 +1,5 @@
 #include "aig.h"
+#include "thread_pool.h"
 #include <stdexcept>
 #include <cstdint>
 #include <algorithm>
@@ -8,28 +9,47 @@
 // =============================================================
 // 构造函数
 // =============================================================
-AigGraph::AigGraph() {
+template <class F>
+AigGraphT<F>::AigGraphT() {
     // node 0 = constant 0
     // 确保节点0始终存在
     nodes.push_back(AigNode{0,0,false});
 }
 
+template <class F>
+AigGraphT<F>::AigGraphT(const AigGraphT& o)
+    : nodes(o.nodes), inputs(o.inputs), outputs(o.outputs),
+      computed_table(o.computed_table), strash_stale(o.strash_stale),
+      num_threads(o.num_threads), levelized_opt(o.levelized_opt) {}
+
+template <class F>
+AigGraphT<F>& AigGraphT<F>::operator=(const AigGraphT& o) {
+    if (this != &o) {
+        AigGraphT tmp(o);
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
 // =============================================================
 // 输入节点
 // =============================================================
-uint32_t AigGraph::addInput() {
-    uint32_t id = nodes.size();
+template <class F>
+AigId AigGraphT<F>::addInput() {
+    AigId id = nodes.size();
     AigNode n;
     n.is_input = true;
     nodes.push_back(n);
     inputs.push_back(id);
+    invalidateFanouts();
     return id; // 返回 ID，用户需自行转 literal
 }
 
 // =============================================================
 // AND节点
 // =============================================================
-uint32_t AigGraph::addAnd(uint32_t lit0, uint32_t lit1) {
+template <class F>
+AigLit AigGraphT<F>::addAnd(AigLit lit0, AigLit lit1) {
     if (lit0 == 0 || lit1 == 0) return 0;
     if (lit0 == 1) return lit1;
     if (lit1 == 1) return lit0;
@@ -39,111 +59,220 @@ uint32_t AigGraph::addAnd(uint32_t lit0, uint32_t lit1) {
     if (lit0 > lit1) std::swap(lit0, lit1);
 
     // 1. 查表：如果这个 AND 门已经存在，直接返回旧的 ID
-    uint64_t key = (static_cast<uint64_t>(lit0) << 32) | lit1;
-    if (computed_table.count(key)) {
-        return computed_table[key];
+    AigKey key = strash_key(lit0, lit1);
+    if constexpr (F::kStrash) {
+        ensureStrash();
+        AigLit hit = computed_table.find(key);
+        if (hit != StrashTable::kNone) {
+            return hit;
+        }
     }
 
     // 2. 检查 ID 是否越界 (安全性)
-    uint32_t id0 = lit_id(lit0);
-    uint32_t id1 = lit_id(lit1);
+    AigId id0 = lit_id(lit0);
+    AigId id1 = lit_id(lit1);
     if(id0 >= nodes.size() || id1 >= nodes.size())
             throw std::out_of_range("addAnd inputs invalid");
 
-    // 3. 创建新节点
-    uint32_t id = nodes.size();
+    // 3. 创建新节点 (有死节点槽位时复用；事务只能回滚追加的节点，不复用)
     AigNode n;
     n.fanin0 = lit0;
     n.fanin1 = lit1;
     n.is_input = false;
-    nodes.push_back(n);
+    AigId id;
+    if (F::kRefCounts && refs_tracked && !free_ids.empty() && !txn_active) {
+        id = free_ids.back();
+        free_ids.pop_back();
+        nodes[id] = n;
+    } else {
+        id = nodes.size();
+        nodes.push_back(n);
+        if (F::kRefCounts && refs_tracked) ref_count.push_back(0);
+    }
+    if (F::kRefCounts && refs_tracked) {
+        refInc(lit0);
+        refInc(lit1);
+    }
+    if constexpr (F::kFanouts) {
+        addFanoutEdge(id0, id);
+        addFanoutEdge(id1, id);
+    } else {
+        fanout_dirty = true;
+    }
 
-    uint32_t res = make_lit(id, false);
+    AigLit res = make_lit(id, false);
     
     // 4. 记录到哈希表
-    computed_table[key] = res;
+    if constexpr (F::kStrash) strashInsert(key, res);
     
     return res;
 }
+
+// =============================================================
+// 批量建 AND
+// =============================================================
+// 逐个 addAnd 时，每次查 strash 的缓存缺失都挡在下一次查找前面。这里先把
+// 两个操作数都已确定的对规范化后一起查表：这些查找互不依赖，每个键提前
+// kBatchPrefetch 个位置预取它的桶，缺失彼此重叠。命中的结果之后不会失效
+// (建节点只往表里加)。
+// 第二遍按顺序解析本批内的引用并建节点；第一遍没命中的 (包括本批内重复的对)
+// 交给 addAnd 重新查，这时对应的表项多半已经在缓存里。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::addAndBatch(const std::vector<std::pair<AigLit, AigLit>>& pairs,
+                               const std::vector<uint8_t>& refs, std::vector<AigLit>& out)
+{
+    const size_t n = pairs.size();
+    if (refs.size() != n) throw std::invalid_argument("addAndBatch: expected one ref mask per pair");
+    out.assign(n, kAigNone);
+
+    // 1. 不依赖本批结果的对先查表 (常量、相同、互补的对留给 addAnd 化简)
+    if constexpr (F::kStrash) {
+        constexpr size_t kBatchPrefetch = 16;
+        ensureStrash();
+        auto key_of = [&](size_t k, AigKey& key) {
+            auto [a, b] = pairs[k];
+            if (refs[k] || a < 2 || b < 2 || lit_id(a) == lit_id(b)) return false;
+            if (a > b) std::swap(a, b);
+            key = strash_key(a, b);
+            return true;
+        };
+        AigKey key;
+        for (size_t k = 0; k < std::min(n, kBatchPrefetch); ++k)
+            if (key_of(k, key)) computed_table.prefetch(key);
+        for (size_t k = 0; k < n; ++k) {
+            if (k + kBatchPrefetch < n && key_of(k + kBatchPrefetch, key)) computed_table.prefetch(key);
+            if (key_of(k, key)) out[k] = computed_table.find(key);
+        }
+    }
+
+    // 2. 按顺序解析引用、建节点
+    auto resolve = [&](AigLit lit, bool is_ref, size_t k) {
+        if (!is_ref) return lit;
+        size_t j = lit_id(lit);
+        if (j >= k) throw std::out_of_range("addAndBatch: reference to a later entry");
+        return out[j] ^ static_cast<AigLit>(lit_inv(lit));
+    };
+    for (size_t k = 0; k < n; ++k) {
+        if (out[k] != kAigNone) continue;
+        out[k] = addAnd(resolve(pairs[k].first, refs[k] & 1, k), resolve(pairs[k].second, refs[k] & 2, k));
+    }
+}
 // =============================================================
 // 输出节点
 // =============================================================
-void AigGraph::addOutput(uint32_t lit) {
-    uint32_t id = lit_id(lit);
+template <class F>
+void AigGraphT<F>::addOutput(AigLit lit) {
+    AigId id = lit_id(lit);
     if(id >= nodes.size())
         throw std::out_of_range("addOutput: literal refers to nonexistent node");
     outputs.push_back(lit);
+    if (F::kRefCounts && refs_tracked) refInc(lit);
+    if (F::kFanouts && !fanout_dirty) output_refs[id].push_back(static_cast<AigId>(outputs.size() - 1));
+}
+
+// =============================================================
+// 遍历标记
+// =============================================================
+// 标记数组按需增长到节点数；已有内容保留，所以遍历中途新建节点也能打标
+template <class F>
+void AigGraphT<F>::growTrav() const {
+    trav_ids.resize(nodes.size(), 0);
+    trav_data.resize(nodes.size(), 0);
+}
+
+template <class F>
+void AigGraphT<F>::incTravId() const {
+    if (trav_ids.size() < nodes.size()) growTrav();
+    // 计数器回绕时整体清零一次
+    if (++trav_id_cur == 0) {
+        std::fill(trav_ids.begin(), trav_ids.end(), 0);
+        trav_id_cur = 1;
+    }
 }
 
 // =============================================================
 // 深度计算
 // =============================================================
-uint32_t AigGraph::depth() const {
-    // 使用 int 而不是 vector<int> 来避免递归中的重复分配? 
-    // 不，这里是一次性计算。
-    std::vector<int> memo(nodes.size(), -1);
+template <class F>
+uint32_t AigGraphT<F>::depth() const {
+    // 遍历 ID 标记 "已算过"，深度存放在 travData 里，
+    // 不再每次分配一个图规模的 memo 数组
+    incTravId();
     uint32_t max_depth = 0;
-    for(uint32_t lit: outputs){
-        uint32_t d = depthRec(lit_id(lit), memo);
+    for(AigLit lit: outputs){
+        uint32_t d = depthRec(lit_id(lit));
         max_depth = std::max(max_depth, d);
     }
     return max_depth;
 }
 
-uint32_t AigGraph::depthRec(uint32_t id, std::vector<int>& memo) const {
+template <class F>
+uint32_t AigGraphT<F>::depthRec(AigId id) const {
     assert(id < nodes.size());
-    if(memo[id] >= 0) return memo[id];
+    if(isTravIdCurrent(id)) return static_cast<uint32_t>(travData(id));
 
     const AigNode& n = nodes[id];
+    uint32_t d = 0;
     // 常量0 (id=0) 或 输入节点，深度为 0
-    if(id == 0 || n.is_input) { 
-        memo[id] = 0; 
-        return 0; 
+    if(id != 0 && !n.is_input) {
+        uint32_t d0 = depthRec(lit_id(n.fanin0));
+        uint32_t d1 = depthRec(lit_id(n.fanin1));
+        d = std::max(d0, d1) + 1;
     }
-
-    uint32_t d0 = depthRec(lit_id(n.fanin0), memo);
-    uint32_t d1 = depthRec(lit_id(n.fanin1), memo);
-    memo[id] = std::max(d0, d1) + 1;
-    return memo[id];
+    setTravIdCurrent(id);
+    travData(id) = d;
+    return d;
 }
 
 // =============================================================
 // 全局优化（去重 + 常量传播）
 // =============================================================
-void AigGraph::optimize() {
-    std::vector<AigNode> new_nodes;
-    std::unordered_map<uint64_t, uint32_t> strash; 
+template <class F>
+void AigGraphT<F>::optimize() {
+    if (txn_active) throw std::logic_error("optimize: not allowed inside a transaction");
+    if (levelized_opt) {
+        optimizeLevelized();
+        return;
+    }
+
+    NodeStore new_nodes;
+    StrashTable::Map strash; 
     
-    // old2new 初始化为 UINT32_MAX，用来标记节点是否已被处理
-    std::vector<uint32_t> old2new(nodes.size(), UINT32_MAX);
+    // 遍历 ID 标记节点是否已被处理，travData 存放旧节点对应的新字面量
+    incTravId();
+    auto set_new = [&](AigId old_id, AigLit lit) {
+        setTravIdCurrent(old_id);
+        travData(old_id) = lit;
+    };
 
     // 1. 初始化常量 0
     new_nodes.push_back(nodes[0]); 
-    old2new[0] = 0; 
+    set_new(0, 0);
 
     // 2. 优先处理 Inputs，保持输入顺序不变
     // (如果不这样做，递归可能会打乱 inputs 的索引顺序)
-    std::vector<uint32_t> new_input_ids;
-    for (uint32_t old_in_id : inputs) {
-        uint32_t new_id = new_nodes.size();
+    std::vector<AigId> new_input_ids;
+    for (AigId old_in_id : inputs) {
+        AigId new_id = new_nodes.size();
         AigNode new_input_node;
         new_input_node.is_input = true;
         new_nodes.push_back(new_input_node);
         
-        old2new[old_in_id] = make_lit(new_id, false);
+        set_new(old_in_id, make_lit(new_id, false));
         new_input_ids.push_back(new_id);
     }
 
     // 3. 定义递归函数：获取旧 Literal 对应的新 Literal
-    std::function<uint32_t(uint32_t)> get_new_lit = 
-        [&](uint32_t old_lit) -> uint32_t {
+    std::function<AigLit(AigLit)> get_new_lit = 
+        [&](AigLit old_lit) -> AigLit {
         
-        uint32_t old_id = lit_id(old_lit);
+        AigId old_id = lit_id(old_lit);
         bool is_inv = lit_inv(old_lit);
 
         // 如果已经处理过，直接返回
-        if (old2new[old_id] != UINT32_MAX) {
-            return old2new[old_id] ^ is_inv;
+        if (isTravIdCurrent(old_id)) {
+            return travData(old_id) ^ is_inv;
         }
 
         // 如果没处理过，递归处理其子节点
@@ -155,11 +284,11 @@ void AigGraph::optimize() {
              throw std::runtime_error("Unexpected unmapped input/const");
         }
 
-        uint32_t l0 = get_new_lit(n.fanin0);
-        uint32_t l1 = get_new_lit(n.fanin1);
+        AigLit l0 = get_new_lit(n.fanin0);
+        AigLit l1 = get_new_lit(n.fanin1);
 
         // 常量传播与代数简化
-        uint32_t res;
+        AigLit res;
         if (l0 == 0 || l1 == 0) { res = 0; }
         else if (l0 == 1) { res = l1; }
         else if (l1 == 1) { res = l0; }
@@ -168,12 +297,12 @@ void AigGraph::optimize() {
         else {
             // Strashing
             if (l0 > l1) std::swap(l0, l1);
-            uint64_t key = (static_cast<uint64_t>(l0) << 32) | l1;
+            AigKey key = strash_key(l0, l1);
             auto it = strash.find(key);
             if (it != strash.end()) {
                 res = it->second;
             } else {
-                uint32_t new_id = new_nodes.size();
+                AigId new_id = new_nodes.size();
                 AigNode new_node;
                 new_node.is_input = false;
                 new_node.fanin0 = l0;
@@ -185,13 +314,13 @@ void AigGraph::optimize() {
         }
 
         // 记录映射结果
-        old2new[old_id] = res;
+        set_new(old_id, res);
         return res ^ is_inv;
     };
 
     // 4. 只从 Outputs 开始递归 (自动去除死逻辑 Dead Logic Elimination)
-    std::vector<uint32_t> new_outputs;
-    for (uint32_t old_out_lit : outputs) {
+    std::vector<AigLit> new_outputs;
+    for (AigLit old_out_lit : outputs) {
         new_outputs.push_back(get_new_lit(old_out_lit));
     }
 
@@ -199,85 +328,119 @@ void AigGraph::optimize() {
     nodes.swap(new_nodes);
     inputs = new_input_ids; // inputs 已经是 ID 了
     outputs = new_outputs;
+    invalidateFanouts();
     
     // 清空 addAnd 用的哈希表，因为 ID 已经全变了
-    computed_table.clear(); 
     // 将 strash 同步回去 下一轮 rewrite 调用 addAnd 时，能立即查到现有的节点
-    for (auto const& [key, lit] : strash) {
-        computed_table[key] = lit;
-    }
+    computed_table.assign(std::move(strash));
+    strash_stale = false;
 }
 
 // =============================================================
 // 统计
 // =============================================================
-uint32_t AigGraph::countAnds() const {
-    uint32_t cnt = 0;
-    // 从1开始，跳过常量0
-    for(size_t i = 1; i < nodes.size(); ++i) {
-        if(!nodes[i].is_input) cnt++;
-    }
-    return cnt;
+template <class F>
+size_t AigGraphT<F>::countAnds() const {
+    // 从1开始，跳过常量0 和死节点；分块计数后按块顺序归约
+    return ThreadPool::global().parallel_reduce(
+        1, nodes.size(), 1 << 16, num_threads, size_t(0),
+        [&](size_t lo, size_t hi) {
+            size_t cnt = 0;
+            for(size_t i = lo; i < hi; ++i) {
+                if(!nodes[i].is_input && !isDeadNode(nodes[i])) cnt++;
+            }
+            return cnt;
+        },
+        [](size_t a, size_t b) { return a + b; });
 }
 
-uint32_t AigGraph::countInverters() const {
-    // 标记数组：记录每个节点的"反相版本"是否被使用过
-    // 默认都是 false
-    std::vector<bool> inverted_used(nodes.size(), false);
+template <class F>
+size_t AigGraphT<F>::countInverters() const {
+    // 遍历 ID 标记：记录每个节点的"反相版本"是否被使用过
+    // 第一次被标记时计数，不需要图规模的数组
+    incTravId();
+    size_t cnt = 0;
+    // 节点以反相形式实现 (phase) 时，正相引用才需要反相器
+    auto use = [&](AigLit lit) {
+        if (lit_inv(lit) != nodes[lit_id(lit)].phase && !isTravIdCurrent(lit_id(lit))) {
+            setTravIdCurrent(lit_id(lit));
+            cnt++;
+        }
+    };
 
     // 1. 遍历所有 AND 门，检查其输入是否使用了反相信号
     for(size_t i = 1; i < nodes.size(); ++i) {
         const auto& n = nodes[i];
         if (n.is_input) continue;
-
-        // 如果 fanin0 是反相的（奇数），标记 fanin0 对应的节点 ID 被反相使用了
-        if (lit_inv(n.fanin0)) {
-            inverted_used[lit_id(n.fanin0)] = true;
-        }
-        // 同理 fanin1
-        if (lit_inv(n.fanin1)) {
-            inverted_used[lit_id(n.fanin1)] = true;
-        }
+        use(n.fanin0);
+        use(n.fanin1);
     }
 
     // 2. 遍历输出，检查输出是否直接引用了反相信号
     // (注意：之前的讨论提到有些工具不统计输出口的反相，
     //  但如果按照"物理反相器"逻辑，输出端若需要反相，也得算1个)
-    for (uint32_t lit : outputs) {
-        if (lit_inv(lit)) {
-            inverted_used[lit_id(lit)] = true;
-        }
+    for (AigLit lit : outputs) {
+        use(lit);
     }
 
-    // 3. 统计有多少个节点被标记了
-    uint32_t cnt = 0;
-    for (bool used : inverted_used) {
-        if (used) cnt++;
-    }
-    
     return cnt;
 }
 
-void AigGraph::print_stats() const {
-    std::cout << "pis=" << inputs.size()
-              << ", pos=" << outputs.size()
-              << ", area=" << countAnds()
-              << ", depth=" << depth()
-              << ", not=" << countInverters()
+template <class F>
+AigStats AigGraphT<F>::stats() const {
+    AigStats s;
+    s.pis = inputs.size();
+    s.pos = outputs.size();
+    s.area = countAnds();
+    s.depth = depth();
+    s.inverters = countInverters();
+    return s;
+}
+
+void print_stats(const AigStats& s) {
+    std::cout << "pis=" << s.pis
+              << ", pos=" << s.pos
+              << ", area=" << s.area
+              << ", depth=" << s.depth
+              << ", not=" << s.inverters
               << std::endl;
 }
 
+template <class F>
+void AigGraphT<F>::print_stats() const {
+    ::print_stats(stats());
+}
+
 // 检查是否存在 AND(lit0, lit1) 的节点
-bool AigGraph::hasAnd(uint32_t lit0, uint32_t lit1) const {
+template <class F>
+bool AigGraphT<F>::hasAnd(AigLit lit0, AigLit lit1) const {
     if (lit0 == 0 || lit1 == 0) return true; // Const 0 exists
     if (lit0 > lit1) std::swap(lit0, lit1);
-    uint64_t key = (static_cast<uint64_t>(lit0) << 32) | lit1;
-    return computed_table.count(key);
+    AigKey key = strash_key(lit0, lit1);
+    ensureStrash();
+    return computed_table.contains(key);
+}
+
+// 查找 AND(lit0, lit1) 对应的已有字面量，不存在时返回 kAigNone
+template <class F>
+AigLit AigGraphT<F>::lookupAnd(AigLit lit0, AigLit lit1) const {
+    if (lit0 > lit1) std::swap(lit0, lit1);
+    AigKey key = strash_key(lit0, lit1);
+    ensureStrash();
+    return computed_table.find(key);
 }
 
 // 计算引用计数
-std::vector<int> AigGraph::build_refs() const {
-    std::vector<int> refs(nodes.size(), 0);
+template <class F>
+std::vector<int> AigGraphT<F>::build_refs() const {
+    std::vector<int> refs;
+    build_refs(refs);
+    return refs;
+}
+
+template <class F>
+void AigGraphT<F>::build_refs(std::vector<int>& refs) const {
+    refs.assign(nodes.size(), 0);
     // 遍历所有节点累加引用
     for (size_t i = 1; i < nodes.size(); ++i) {
         if (nodes[i].is_input) continue;
@@ -285,10 +448,53 @@ std::vector<int> AigGraph::build_refs() const {
         refs[lit_id(nodes[i].fanin1)]++;
     }
     // 输出也是引用
-    for (uint32_t out : outputs) {
+    for (AigLit out : outputs) {
         refs[lit_id(out)]++;
     }
-    return refs;
+}
+
+// =============================================================
+// 扇出索引 (CSR)
+// =============================================================
+template <class F>
+void AigGraphT<F>::buildFanouts() const {
+    const size_t N = nodes.size();
+
+    // 1. 第一遍：统计每个节点的扇出数，前缀和得到起始位置
+    fanout_start.assign(N + 1, 0);
+    for (size_t i = 1; i < N; ++i) {
+        if (nodes[i].is_input) continue;
+        fanout_start[lit_id(nodes[i].fanin0) + 1]++;
+        fanout_start[lit_id(nodes[i].fanin1) + 1]++;
+    }
+    for (size_t i = 0; i < N; ++i) fanout_start[i + 1] += fanout_start[i];
+
+    // 2. 第二遍：按 ID 顺序填入扇出，每个区间内天然有序
+    //    填的时候把 start[i] 当游标用，填完后它正好变成 start[i+1]，
+    //    整体右移一位即可复原，不需要额外的游标数组
+    fanout_ids.resize(fanout_start[N]);
+    for (size_t i = 1; i < N; ++i) {
+        if (nodes[i].is_input) continue;
+        fanout_ids[fanout_start[lit_id(nodes[i].fanin0)]++] = static_cast<AigId>(i);
+        fanout_ids[fanout_start[lit_id(nodes[i].fanin1)]++] = static_cast<AigId>(i);
+    }
+    for (size_t i = N; i > 0; --i) fanout_start[i] = fanout_start[i - 1];
+    fanout_start[0] = 0;
+
+    // 3. PO 引用和溢出表从头开始
+    fanout_extra.clear();
+    output_refs.clear();
+    for (size_t i = 0; i < outputs.size(); ++i)
+        output_refs[lit_id(outputs[i])].push_back(static_cast<AigId>(i));
+    fanout_dirty = false;
+}
+
+template <class F>
+FanoutRange AigGraphT<F>::fanouts(AigId id) const {
+    assert(id < nodes.size());
+    if (fanout_dirty || fanout_start.size() != nodes.size() + 1 || !fanout_extra.empty()) buildFanouts();
+    const AigId* base = fanout_ids.data();
+    return FanoutRange{base + fanout_start[id], base + fanout_start[id + 1]};
 }
 
 // =============================================================
@@ -296,27 +502,28 @@ std::vector<int> AigGraph::build_refs() const {
 // =============================================================
 
 
-bool rewriteRedundant(uint32_t id, AigGraph& g, uint32_t& new_lit)
+bool rewriteRedundant(AigId id, AigGraph& g, AigLit& new_lit)
 {
     const auto& n = g.nodes[id];
     if (n.is_input) return false;
 
-    uint32_t x = n.fanin0;
-    uint32_t y = n.fanin1;
+    AigLit x = n.fanin0;
+    AigLit y = n.fanin1;
 
-    uint32_t xid = lit_id(x);
-    uint32_t yid = lit_id(y);
+    AigId xid = lit_id(x);
+    AigId yid = lit_id(y);
 
-    if (!g.nodes[xid].is_input) {
-        auto& nx = g.nodes[xid];
+    // 只有不反相的 fanin 才能吸收另一个 fanin：AND(~AND(y, z), y) != ~AND(y, z)
+    if (!lit_inv(x) && !g.nodes[xid].is_input) {
+        const auto& nx = g.nodes[xid];
         if (nx.fanin0 == y || nx.fanin1 == y) {
             new_lit = x;
             return true;
         }
     }
 
-    if (!g.nodes[yid].is_input) {
-        auto& ny = g.nodes[yid];
+    if (!lit_inv(y) && !g.nodes[yid].is_input) {
+        const auto& ny = g.nodes[yid];
         if (ny.fanin0 == x || ny.fanin1 == x) {
             new_lit = y;
             return true;
@@ -325,83 +532,150 @@ bool rewriteRedundant(uint32_t id, AigGraph& g, uint32_t& new_lit)
     return false;
 }
 
-bool rewriteCommonFactor_P1(uint32_t id, AigGraph& g, const std::vector<int>& refs, uint32_t& new_lit)
+// 公因子提取拆成两步：
+//   matchCommonFactor 只读图，找出 AND(AND(c,a), AND(c,b)) 形式并记下增益
+//   applyCommonFactor 做代价评估 (查 strash) 并真正建节点
+// 这样匹配可以在快照上并行做，只有 apply 需要串行
+struct CommonFactorMatch {
+    AigLit c = 0, a = 0, b = 0;
+    int gain = 0;
+};
+
+bool matchCommonFactor(AigId id, const AigGraph& g, const std::vector<AigId>& refs, CommonFactorMatch& m)
 {
     if (g.nodes[id].is_input) return false;
 
     // 1. 安全拷贝 (这是之前修好的部分)
-    uint32_t x = g.nodes[id].fanin0;
-    uint32_t y = g.nodes[id].fanin1;
+    AigLit x = g.nodes[id].fanin0;
+    AigLit y = g.nodes[id].fanin1;
     
-    // 快速检查：如果 x 或 y 是输入，无法提取
+    // 快速检查：如果 x 或 y 是输入，无法提取；反相的 x / y 不是 AND，也不能提取
+    if (lit_inv(x) || lit_inv(y)) return false;
     if (g.nodes[lit_id(x)].is_input || g.nodes[lit_id(y)].is_input) return false;
 
     // 拷贝孙子节点
-    uint32_t xa = g.nodes[lit_id(x)].fanin0; 
-    uint32_t xb = g.nodes[lit_id(x)].fanin1;
-    uint32_t ya = g.nodes[lit_id(y)].fanin0;
-    uint32_t yb = g.nodes[lit_id(y)].fanin1;
-
-    // 2. 定义带代价评估的 pull 函数
-    auto pull = [&](uint32_t c, uint32_t a, uint32_t b) {
-        // --- 代价评估 (Heuristic) ---
-        
-        // 增益：如果原节点 x 或 y 引用计数为1，重写后它们将成为死节点 (Gain +1 each)
-        // 注意：这里用 refs[id] 是不准的，我们要看 x 和 y 的 ref
-        int gain = 0;
-        if (refs[lit_id(x)] == 1) gain++;
-        if (refs[lit_id(y)] == 1) gain++;
-
-        // 代价：我们需要创建 t = AND(a, b) 和 res = AND(c, t)
-        // 如果 t 已经存在，代价较小
-        bool t_exists = g.hasAnd(a, b);
-        int cost = (t_exists ? 0 : 1) + 1; // +1 是为了那个新的根节点 (new_lit)
-
-        // 决策：只有当 增益 >= 代价 时才重写
-        // 特例：如果只是单纯的结构调整（gain < cost），可能会导致 mem_ctrl 变差
-        // 所以我们严格要求：
-        if (gain < cost) return false;
-
-        // --- 执行重写 ---
-        uint32_t t = g.addAnd(a, b);   
-        new_lit = g.addAnd(c, t);
+    AigLit xa = g.nodes[lit_id(x)].fanin0; 
+    AigLit xb = g.nodes[lit_id(x)].fanin1;
+    AigLit ya = g.nodes[lit_id(y)].fanin0;
+    AigLit yb = g.nodes[lit_id(y)].fanin1;
+
+    // 增益：如果原节点 x 或 y 引用计数为1，重写后它们将成为死节点 (Gain +1 each)
+    // 注意：这里用 refs[id] 是不准的，我们要看 x 和 y 的 ref
+    m.gain = 0;
+    if (refs[lit_id(x)] == 1) m.gain++;
+    if (refs[lit_id(y)] == 1) m.gain++;
+
+    auto set = [&](AigLit c, AigLit a, AigLit b) {
+        m.c = c; m.a = a; m.b = b;
         return true;
     };
 
-    if (xa == ya) return pull(xa, xb, yb);
-    if (xa == yb) return pull(xa, xb, ya);
-    if (xb == ya) return pull(xb, xa, yb);
-    if (xb == yb) return pull(xb, xa, ya);
+    if (xa == ya) return set(xa, xb, yb);
+    if (xa == yb) return set(xa, xb, ya);
+    if (xb == ya) return set(xb, xa, yb);
+    if (xb == yb) return set(xb, xa, ya);
 
     return false;
 }
 
-void AigGraph::rewrite_phase1()
+bool applyCommonFactor(AigGraph& g, const CommonFactorMatch& m, AigLit& new_lit)
 {
-    const uint32_t N = nodes.size();
-    
-    // 1. 预计算引用计数 (Static Reference Counting)
-    // 虽然重写过程中引用会动态变化，但静态近似通常足够且高效
-    std::vector<int> refs = build_refs();
+    // --- 代价评估 (Heuristic) ---
+
+    // 代价：我们需要创建 t = AND(a, b) 和 res = AND(c, t)
+    // 如果 t 已经存在，代价较小
+    bool t_exists = g.hasAnd(m.a, m.b);
+    int cost = (t_exists ? 0 : 1) + 1; // +1 是为了那个新的根节点 (new_lit)
+
+    // 决策：只有当 增益 >= 代价 时才重写
+    // 特例：如果只是单纯的结构调整（gain < cost），可能会导致 mem_ctrl 变差
+    // 所以我们严格要求：
+    if (m.gain < cost) return false;
+
+    // --- 执行重写 ---
+    AigLit t = g.addAnd(m.a, m.b);   
+    new_lit = g.addAnd(m.c, t);
+    return true;
+}
 
-    for (uint32_t id = 1; id < N; ++id) {
-        if (nodes[id].is_input) continue;
+bool rewriteCommonFactor_P1(AigId id, AigGraph& g, const std::vector<AigId>& refs, AigLit& new_lit)
+{
+    CommonFactorMatch m;
+    return matchCommonFactor(id, g, refs, m) && applyCommonFactor(g, m, new_lit);
+}
 
-        uint32_t new_lit;
-        
-        // 传入 refs
-        if (rewriteCommonFactor_P1(id, *this, refs, new_lit))
-        {
-            nodes[id].fanin0 = new_lit;
-            nodes[id].fanin1 = 1; 
-            
-            // 可选：在这里简单更新 refs，虽然对于 complex graph 不一定完全准确
-            // 但对于单次 pass 来说，不更新也是为了防止连锁反应导致的震荡
+// 投机并行：
+//   1. 各线程在还没有改动的图上为每个节点做 matchCommonFactor，
+//      只按块记下找到的匹配 (通常远少于节点数)
+//      读集合 = {id, x, y}，写集合 = id 的扇出 (replace 改写它们)
+//   2. 按 ID 顺序串行提交，每个匹配用 replace(id, new_lit) 落到图上。
+//      若读集合里任何一个节点的 fanin 已经和快照不同 (被前面的 replace
+//      改写、删掉或复用了槽位)，快照上的匹配作废，在当前图上重新匹配；
+//      否则匹配结果仍然有效，只需重新做代价评估 (strash 可能已经多了节点)
+// 增益看 replace 维护的引用计数：快照上的匹配用匹配时刻的值 (静态近似)，
+// 重新匹配时用当前的值。
+// 结束时回收死节点并按后序重新编号，后面的 pass 照常拿到拓扑序的 ID
+template <class F>
+void AigGraphT<F>::rewrite_phase1()
+{
+    if (txn_active) throw std::logic_error("rewrite_phase1: not allowed inside a transaction");
+    if (!refs_tracked) buildRefCounts();
+    const AigId N = nodes.size();
+
+    // 1. 匹配阶段只读，直接读 nodes 和 ref_count；每 kGrain 个 ID 一个桶，
+    //    桶内按 ID 递增，各桶只有一个线程写
+    constexpr size_t kGrain = 4096;
+    std::vector<std::vector<std::pair<AigId, CommonFactorMatch>>> found((N + kGrain - 1) / kGrain);
+    ThreadPool::global().parallel_for(1, N, kGrain, num_threads, [&](size_t lo, size_t hi) {
+        CommonFactorMatch m;
+        for (AigId id = lo; id < hi; ++id)
+            if (matchCommonFactor(id, *this, ref_count, m)) found[(id - 1) / kGrain].emplace_back(id, m);
+    });
+
+    // 快照：只复制块指针，之后 replace 写到哪块才复制哪块。只在提交循环里用，
+    // 出了这个块就释放，后面的删除和回收不再为它复制块
+    const NodeStore& cur = nodes;
+    {
+        const NodeStore snap = nodes;
+        size_t bucket = 0, pos = 0;
+        auto snapMatch = [&](AigId id) -> const CommonFactorMatch* {
+            for (; bucket < found.size(); ++bucket, pos = 0) {
+                const auto& b = found[bucket];
+                while (pos < b.size() && b[pos].first < id) ++pos;
+                if (pos < b.size()) return b[pos].first == id ? &b[pos].second : nullptr;
+            }
+            return nullptr;
+        };
+
+        auto changed = [&](AigId k) {
+            const AigNode a = cur[k], b = snap[k];
+            return a.is_input != b.is_input || a.fanin0 != b.fanin0 || a.fanin1 != b.fanin1;
+        };
+        for (AigId id = 1; id < N; ++id) {
+            const AigNode n = cur[id];
+            if (n.is_input || isDeadNode(n) || ref_count[id] == 0) continue;
+
+            bool conflict = changed(id) || changed(lit_id(n.fanin0)) || changed(lit_id(n.fanin1));
+            const CommonFactorMatch* m = snapMatch(id);
+            AigLit new_lit;
+            if (conflict ? rewriteCommonFactor_P1(id, *this, ref_count, new_lit)
+                         : m && applyCommonFactor(*this, *m, new_lit))
+            {
+                if (lit_id(new_lit) != id) replace(id, new_lit);
+            }
         }
     }
+    found.clear();
+    found.shrink_to_fit();
+
+    // 2. 代价评估通过但没用上的新节点 (new_lit 与 id 相同时) 没有引用，一并删掉
+    for (AigId id = 1; id < nodes.size(); ++id)
+        if (!cur[id].is_input && !isDeadNode(cur[id]) && ref_count[id] == 0) ref_zero.push_back(id);
+    deleteUnreferenced();
+    reclaim(0.0);
 }
 
-bool rewriteNegAbsorb(uint32_t id, AigGraph& g,uint32_t& new_lit)
+bool rewriteNegAbsorb(AigId id, AigGraph& g,AigLit& new_lit)
 {
     const auto& n = g.nodes[id];
     if (n.is_input) return false;
@@ -414,43 +688,85 @@ bool rewriteNegAbsorb(uint32_t id, AigGraph& g,uint32_t& new_lit)
     return false;
 }
 
-void AigGraph::rewrite_phase2()
+template <class F>
+void AigGraphT<F>::rewrite_phase2()
 {
-    const uint32_t N = nodes.size();
-    std::vector<uint32_t> replace(N, UINT32_MAX);
-
-    for (uint32_t id = 1; id < N; ++id) {
-        if (nodes[id].is_input) continue;
-
-        uint32_t new_lit;
-        if (rewriteNegAbsorb(id, *this, new_lit) ||
-            rewriteRedundant(id, *this, new_lit) ||
-            (nodes[id].fanin0 == nodes[id].fanin1 &&
-             (new_lit = nodes[id].fanin0, true)))
-        {
-            replace[id] = new_lit;
+    if (txn_active) throw std::logic_error("rewrite_phase2: not allowed inside a transaction");
+    const AigId N = nodes.size();
+    std::vector<AigLit> replace(N, kAigNone);
+
+    // 检测只读 fanin、只写 replace[id]；补丁只写 nodes[id]、只读 replace。
+    // 两个循环都按 ID 分块并行 (num_threads > 1 时)，结果与串行完全一致
+    // 并行写 nodes 之前先让所有块独占
+    nodes.detach();
+    ThreadPool& pool = ThreadPool::global();
+    constexpr size_t kGrain = 4096;
+
+    pool.parallel_for(1, N, kGrain, num_threads, [&](size_t lo, size_t hi) {
+        for (AigId id = lo; id < hi; ++id) {
+            if (nodes[id].is_input) continue;
+
+            AigLit new_lit;
+            if (rewriteNegAbsorb(id, *this, new_lit) ||
+                rewriteRedundant(id, *this, new_lit) ||
+                (nodes[id].fanin0 == nodes[id].fanin1 &&
+                 (new_lit = nodes[id].fanin0, true)))
+            {
+                replace[id] = new_lit;
+            }
         }
-    }
+    });
 
-    for (uint32_t id = 1; id < N; ++id) {
-        auto& n = nodes[id];
-        if (n.is_input) continue;
+    pool.parallel_for(1, N, kGrain, num_threads, [&](size_t lo, size_t hi) {
+        for (AigId id = lo; id < hi; ++id) {
+            auto&& n = nodes[id];
+            if (n.is_input) continue;
 
-        if (replace[lit_id(n.fanin0)] != UINT32_MAX)
-            n.fanin0 = replace[lit_id(n.fanin0)] ^ lit_inv(n.fanin0);
+            if (replace[lit_id(n.fanin0)] != kAigNone)
+                n.fanin0 = replace[lit_id(n.fanin0)] ^ lit_inv(n.fanin0);
 
-        if (replace[lit_id(n.fanin1)] != UINT32_MAX)
-            n.fanin1 = replace[lit_id(n.fanin1)] ^ lit_inv(n.fanin1);
-    }
+            if (replace[lit_id(n.fanin1)] != kAigNone)
+                n.fanin1 = replace[lit_id(n.fanin1)] ^ lit_inv(n.fanin1);
+        }
+    });
 
     optimize();
 }
 
-void AigGraph::rewrite()
+template <class F>
+void AigGraphT<F>::rewrite()
 {
     for (int i = 0; i < 3; ++i) {
         rewrite_phase1();   // 制造结构
         optimize();         // strash 折叠
         rewrite_phase2();   // 真正减少 AND
     }
-}
\ No newline at end of file
+    assignPhases();         // 不改面积，只减少反相器
+}
+
+// =============================================================
+// 显式实例化
+// =============================================================
+// 默认实例化本文件里的全部成员；AigPlainGraph 只要建图和统计
+template class AigGraphT<AigFullFeatures>;
+
+template AigPlainGraph::AigGraphT();
+template AigPlainGraph::AigGraphT(const AigGraphT&);
+template AigPlainGraph& AigPlainGraph::operator=(const AigGraphT&);
+template AigId AigPlainGraph::addInput();
+template AigLit AigPlainGraph::addAnd(AigLit, AigLit);
+template void AigPlainGraph::addAndBatch(const std::vector<std::pair<AigLit, AigLit>>&, const std::vector<uint8_t>&,
+                                         std::vector<AigLit>&);
+template void AigPlainGraph::addOutput(AigLit);
+template void AigPlainGraph::growTrav() const;
+template void AigPlainGraph::incTravId() const;
+template uint32_t AigPlainGraph::depth() const;
+template size_t AigPlainGraph::countAnds() const;
+template size_t AigPlainGraph::countInverters() const;
+template AigStats AigPlainGraph::stats() const;
+template void AigPlainGraph::print_stats() const;
+template bool AigPlainGraph::hasAnd(AigLit, AigLit) const;
+template AigLit AigPlainGraph::lookupAnd(AigLit, AigLit) const;
+template std::vector<int> AigPlainGraph::build_refs() const;
+template void AigPlainGraph::build_refs(std::vector<int>&) const;
+template FanoutRange AigPlainGraph::fanouts(AigId) const;
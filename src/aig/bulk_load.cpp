@@ -0,0 +1,48 @@
+#include "aig.h"
+#include <stdexcept>
+
+// =============================================================
+// 可信输入的批量装载
+// =============================================================
+// 来自其它工具的 AIG 通常已经 strash 过，逐个 addAnd 查表去重纯属浪费。
+// bulkLoad 只做每个节点 O(1) 的合法性检查，把 fanin 原样追加进 nodes，
+// strash 标记为过期；之后第一次需要查表时 buildStrash() 一遍扫描补建。
+// 只读统计的流程从头到尾不建 strash；optimize() 整体重建 strash 时直接清掉标记。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::bulkLoad(const std::vector<AigLit>& fanin0, const std::vector<AigLit>& fanin1)
+{
+    if (fanin0.size() != fanin1.size())
+        throw std::invalid_argument("bulkLoad: fanin arrays differ in length");
+    if (txn_active) throw std::logic_error("bulkLoad: not allowed inside a transaction");
+    if (conc) throw std::logic_error("bulkLoad: not allowed during concurrent construction");
+
+    AigId id = nodes.size();
+    for (size_t k = 0; k < fanin0.size(); ++k, ++id) {
+        AigLit a = fanin0[k], b = fanin1[k];
+        if (a > b) std::swap(a, b);
+        if (a < 2 || lit_id(a) == lit_id(b) || lit_id(b) >= id)
+            throw std::invalid_argument("bulkLoad: AND " + std::to_string(id) + " is not canonical");
+        nodes.push_back(AigNode{a, b, false});
+    }
+    invalidateFanouts();
+    if (F::kStrash && !fanin0.empty()) strash_stale = true;
+}
+
+template <class F>
+void AigGraphT<F>::buildStrash() const
+{
+    StrashTable::Map strash;
+    strash.reserve(nodes.size());
+    for (AigId id = 1; id < nodes.size(); ++id) {
+        const AigNode& n = nodes[id];
+        if (n.is_input || isDeadNode(n)) continue;
+        strash.emplace(strash_key(n.fanin0, n.fanin1), make_lit(id, false));     // 重复时保留先出现的
+    }
+    computed_table.assign(std::move(strash));
+    strash_stale = false;
+}
+
+template void AigGraph::bulkLoad(const std::vector<AigLit>&, const std::vector<AigLit>&);
+template void AigGraph::buildStrash() const;
+template void AigPlainGraph::bulkLoad(const std::vector<AigLit>&, const std::vector<AigLit>&);
@@ -0,0 +1,163 @@
+#include "aig.h"
+#include "concurrent_strash.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+// =============================================================
+// 并发构造 (多线程同时 addAnd)
+// =============================================================
+// nodes 预先扩到 base + capacity，线程按 kChunk 个一组从原子计数器领取 ID，
+// 领到的位置只有自己写，因此不需要锁住 nodes.push_back。
+// 未使用的位置填哨兵 fanin，endConcurrent 时压缩掉。
+// -------------------------------------------------------------
+namespace {
+constexpr AigId kChunk = 1024;
+constexpr AigId kHole = kAigNone;      // 预留但未使用的位置
+}
+
+struct ConcurrentBuild {
+    ConcurrentBuild(size_t expected) : table(expected) {}
+
+    ConcurrentStrash table;
+    std::atomic<AigId> next{0};
+    AigId base = 0;
+    AigId limit = 0;
+};
+
+template <class F>
+void AigGraphT<F>::beginConcurrent(size_t max_new_nodes, unsigned max_threads) {
+    if (conc) throw std::logic_error("beginConcurrent: already in concurrent mode");
+    if (txn_active) throw std::logic_error("beginConcurrent: not allowed inside a transaction");
+    const AigId base = nodes.size();
+    // 每个线程最后一块可能用不满，多留出一些块的余量
+    const size_t capacity = max_new_nodes + static_cast<size_t>(kChunk) * std::max(1u, max_threads);
+    if (base + capacity > (kAigNone >> 1))
+        throw std::length_error("beginConcurrent: too many nodes");
+
+    ensureStrash();
+    conc = std::make_shared<ConcurrentBuild>(computed_table.sizeHint() + capacity);
+    conc->base = base;
+    conc->limit = static_cast<AigId>(base + capacity);
+    conc->next.store(base);
+
+    AigNode hole;
+    hole.fanin0 = hole.fanin1 = kHole;
+    nodes.resize(conc->limit, hole);
+    nodes.detach();     // 之后各线程并发写 nodes[id]，不能再触发写时复制
+
+    computed_table.forEach([&](const AigKey& key, AigLit lit) {
+        size_t s = conc->table.slot(key);
+        conc->table.fetchMin(s, lit);
+    });
+}
+
+template <class F>
+AigLit AigGraphT<F>::addAndConcurrent(AigLit lit0, AigLit lit1, AigIdChunk& chunk) {
+    if (lit0 == 0 || lit1 == 0) return 0;
+    if (lit0 == 1) return lit1;
+    if (lit1 == 1) return lit0;
+    if (lit0 == lit1) return lit0;
+    if (lit0 == (lit1 ^ 1)) return 0;
+
+    if (lit0 > lit1) std::swap(lit0, lit1);
+    if (lit_id(lit1) >= conc->limit)
+        throw std::out_of_range("addAndConcurrent inputs invalid");
+
+    // 先保证手里有空闲 ID：抢到键之后就不能再失败，否则等待者会一直等下去
+    if (chunk.next == chunk.end) {
+        // 接近上限时只领剩下的部分
+        AigId first = conc->next.load();
+        AigId last;
+        do {
+            if (first >= conc->limit)
+                throw std::length_error("addAndConcurrent: reserved capacity exhausted");
+            last = first + std::min(kChunk, conc->limit - first);
+        } while (!conc->next.compare_exchange_weak(first, last));
+        chunk.next = first;
+        chunk.end = last;
+    }
+
+    // 抢到键的线程负责建节点并发布字面量，其余线程等它发布
+    bool inserted;
+    size_t s = conc->table.slot(ConcurrentStrash::makeKey(lit0, lit1), inserted);
+    if (!inserted) return static_cast<AigLit>(conc->table.wait(s));
+
+    AigId id = chunk.next++;
+    // 只写 fanin：预留时已经填好 is_input = false，位标记可能与相邻节点共用一个字
+    auto&& n = nodes[id];
+    n.fanin0 = lit0;
+    n.fanin1 = lit1;
+
+    AigLit res = make_lit(id, false);
+    conc->table.fetchMin(s, res);
+    return res;
+}
+
+template <class F>
+void AigGraphT<F>::endConcurrent(std::vector<AigLit>& lits) {
+    if (!conc) throw std::logic_error("endConcurrent: not in concurrent mode");
+    const AigId base = conc->base;
+    const AigId used_end = conc->next.load();
+
+    // 1. 跳过空洞，按 fanin 优先的深度优先后序给新节点重新编号 (travData 存新 ID)。
+    //    线程可能用到别的线程块里 ID 更大的新节点，只按原 ID 压缩不能保证拓扑序
+    incTravId();
+    AigId next_id = base;
+    std::vector<AigId> stack;
+    for (AigId root = base; root < used_end; ++root) {
+        if (nodes[root].fanin0 == kHole || isTravIdCurrent(root)) continue;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const AigId id = stack.back();
+            if (isTravIdCurrent(id)) {
+                stack.pop_back();
+                continue;
+            }
+            const AigNode n = nodes[id];
+            bool ready = true;
+            for (AigLit f : {n.fanin0, n.fanin1}) {
+                const AigId c = lit_id(f);
+                if (c >= base && !isTravIdCurrent(c)) {
+                    stack.push_back(c);
+                    ready = false;
+                }
+            }
+            if (!ready) continue;
+            stack.pop_back();
+            setTravIdCurrent(id);
+            travData(id) = next_id++;
+        }
+    }
+    auto remap = [&](AigLit lit) {
+        AigId id = lit_id(lit);
+        return id < base ? lit : make_lit(travData(id), lit_inv(lit));
+    };
+
+    // 2. 改写 fanin 后按新编号放回 (新旧位置可能交叉，先拷出来)，再改写调用方持有的字面量
+    std::vector<AigNode> moved(next_id - base);
+    for (AigId id = base; id < used_end; ++id) {
+        if (nodes[id].fanin0 == kHole) continue;
+        AigNode n = nodes[id];
+        n.fanin0 = remap(n.fanin0);
+        n.fanin1 = remap(n.fanin1);
+        if (n.fanin0 > n.fanin1) std::swap(n.fanin0, n.fanin1);
+        moved[travData(id) - base] = n;
+    }
+    for (AigId id = base; id < next_id; ++id) nodes[id] = moved[id - base];
+    nodes.resize(next_id);
+    for (AigLit& lit : lits) lit = remap(lit);
+
+    // 3. 新节点补进 computed_table
+    for (AigId id = base; id < next_id; ++id) {
+        const AigNode& n = nodes[id];
+        computed_table.insert(strash_key(n.fanin0, n.fanin1), make_lit(id, false));
+    }
+    conc.reset();
+    invalidateFanouts();
+}
+
+template void AigGraph::beginConcurrent(size_t, unsigned);
+template AigLit AigGraph::addAndConcurrent(AigLit, AigLit, AigIdChunk&);
+template void AigGraph::endConcurrent(std::vector<AigLit>&);
@@ -0,0 +1,77 @@
+#include "aig.h"
+#include <vector>
+#include <cstdint>
+
+// =============================================================
+// 重汇聚驱动的割集 (Reconvergence-driven cut)
+// =============================================================
+// refactor、resub、don't-care 计算都需要根节点周围一个有界的窗口。
+// 这里从 root 的两个 fanin 出发，每次挑一个展开后新增叶子最少的叶子
+// 展开 (两个 fanin 都已在割集内时代价为 -1，即重汇聚)，直到叶子数或锥
+// 大小到达上限。整个过程只用遍历 ID 打标，不分配图规模的数组。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::reconvCut(AigId root, uint32_t max_leaves, uint32_t max_cone,
+                         std::vector<AigId>& leaves, std::vector<AigId>& cone) const
+{
+    assert(root < nodes.size() && !nodes[root].is_input);
+    leaves.clear();
+    cone.clear();
+
+    // 1. 当前遍历 ID 标记 "已在割集中" (根、已展开节点、叶子)
+    incTravId();
+    setTravIdCurrent(root);
+    for (AigLit f : {nodes[root].fanin0, nodes[root].fanin1}) {
+        AigId fid = lit_id(f);
+        if (fid == 0 || isTravIdCurrent(fid)) continue;   // 常量不占叶子
+        setTravIdCurrent(fid);
+        leaves.push_back(fid);
+    }
+
+    uint32_t internal = 1;
+    while (internal < max_cone) {
+        int best = -1, best_cost = 3;
+        for (size_t i = 0; i < leaves.size(); ++i) {
+            const AigNode& n = nodes[leaves[i]];
+            if (n.is_input) continue;
+            int cost = -1;
+            for (AigLit f : {n.fanin0, n.fanin1})
+                if (lit_id(f) != 0 && !isTravIdCurrent(lit_id(f))) ++cost;
+            if (cost < best_cost) { best = static_cast<int>(i); best_cost = cost; }
+        }
+        if (best < 0 || leaves.size() + best_cost > max_leaves) break;
+
+        AigId id = leaves[best];
+        leaves.erase(leaves.begin() + best);
+        ++internal;
+        for (AigLit f : {nodes[id].fanin0, nodes[id].fanin1}) {
+            AigId fid = lit_id(f);
+            if (fid == 0 || isTravIdCurrent(fid)) continue;
+            setTravIdCurrent(fid);
+            leaves.push_back(fid);
+        }
+    }
+
+    // 2. 换一个遍历 ID，叶子和常量先打标，从 root 做非递归后序 DFS
+    //    得到锥内节点的拓扑序
+    incTravId();
+    setTravIdCurrent(0);
+    for (AigId id : leaves) setTravIdCurrent(id);
+
+    trav_stack.assign(1, {root, false});
+    while (!trav_stack.empty()) {
+        auto [id, expanded] = trav_stack.back();
+        trav_stack.pop_back();
+        if (expanded) {
+            cone.push_back(id);
+            continue;
+        }
+        if (isTravIdCurrent(id)) continue;
+        setTravIdCurrent(id);
+        trav_stack.push_back({id, true});
+        for (AigLit f : {nodes[id].fanin0, nodes[id].fanin1})
+            if (!isTravIdCurrent(lit_id(f))) trav_stack.push_back({lit_id(f), false});
+    }
+}
+
+template void AigGraph::reconvCut(AigId, uint32_t, uint32_t, std::vector<AigId>&, std::vector<AigId>&) const;
@@ -0,0 +1,220 @@
+#include "aig.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// =============================================================
+// 引用计数与死节点回收
+// =============================================================
+// 引用计数 = AND 扇出数 + PO 引用数。第一次 replace() 时 O(N) 建一次，
+// 之后 relink / setOutput / addAnd / addOutput 各自增减，不再整图扫描。
+// 计数降到 0 的节点连同只被它引用的锥一起删除：从 strash 摘掉，
+// fanin 清成 (0, 0)，槽位进入空闲表供 addAnd 复用。
+// 死节点不移动，编号保持稳定；死槽位积累到一定比例时 reclaim() 一次性挤掉。
+// addAnd 复用的槽位可能排在自己的 fanin 前面，所以 reclaim() 按后序 DFS
+// 重新编号，而不是保持原来的相对顺序。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::buildRefCounts()
+{
+    ref_count.assign(nodes.size(), 0);
+    free_ids.clear();
+    ref_zero.clear();
+    for (size_t id = nodes.size(); id-- > 1;) {
+        const AigNode& n = nodes[id];
+        if (n.is_input) continue;
+        if (isDeadNode(n)) {
+            free_ids.push_back(static_cast<AigId>(id));
+            continue;
+        }
+        ++ref_count[lit_id(n.fanin0)];
+        ++ref_count[lit_id(n.fanin1)];
+    }
+    for (AigLit lit : outputs) ++ref_count[lit_id(lit)];
+    refs_tracked = true;
+}
+
+template <class F>
+void AigGraphT<F>::deleteUnreferenced()
+{
+    // relink 把 fanin 的计数减到 0 时会继续压进 ref_zero，循环到锥删完为止
+    while (!ref_zero.empty()) {
+        AigId id = ref_zero.back();
+        ref_zero.pop_back();
+        const AigNode& n = nodes[id];
+        if (n.is_input || isDeadNode(n) || ref_count[id] != 0) continue;
+        unhashNode(id);
+        relink(id, 0, 0);
+        free_ids.push_back(id);
+    }
+}
+
+template <class F>
+size_t AigGraphT<F>::deadCount() const
+{
+    if (refs_tracked) return free_ids.size();
+    size_t cnt = 0;
+    for (size_t id = 1; id < nodes.size(); ++id) cnt += isDeadNode(nodes[id]);
+    return cnt;
+}
+
+// =============================================================
+// 重新编号
+// =============================================================
+// order 按新顺序列出保留的旧 ID (以 0 开头，不在其中的节点被丢弃)。
+// fanin、输入、输出和 strash 里的字面量按同一张映射改写；结构不变，
+// 不做 optimize() 那样的重新 strash。新编号不一定保持 fanin 的大小关系，
+// 改写后重新排成 fanin0 < fanin1，与 strash 键一致。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::renumber(const std::vector<AigId>& order)
+{
+    incTravId();
+    for (size_t k = 0; k < order.size(); ++k) {
+        setTravIdCurrent(order[k]);
+        travData(order[k]) = static_cast<AigLit>(k);
+    }
+    auto map = [&](AigLit lit) { return make_lit(travData(lit_id(lit)), lit_inv(lit)); };
+
+    const NodeStore& old_nodes = nodes;     // 只读，不触发写时复制
+    NodeStore fresh;
+    fresh.resize(order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+        AigNode n = old_nodes[order[k]];
+        if (!n.is_input) {
+            n.fanin0 = map(n.fanin0);
+            n.fanin1 = map(n.fanin1);
+            if (n.fanin0 > n.fanin1) std::swap(n.fanin0, n.fanin1);
+        }
+        fresh[k] = n;
+    }
+    nodes.swap(fresh);
+    for (AigId& id : inputs) id = travData(id);
+    for (AigLit& lit : outputs) lit = map(lit);
+
+    // 被丢弃的节点已经从 strash 摘掉，这里只是跳过残留的过期记录；
+    // strash 本来就要在用到时重建 (bulkLoad 之后) 的话不必改写
+    if (strash_stale) {
+        computed_table.clear();
+    } else {
+        // 先把改写后的记录收进数组、释放旧表，再建新表：
+        // 同一时刻只有一张哈希表在内存里
+        std::vector<std::pair<AigKey, AigLit>> entries;
+        entries.reserve(computed_table.sizeHint());
+        computed_table.forEach([&](const AigKey& key, AigLit lit) {
+            AigLit a = key_lit0(key), b = key_lit1(key);
+            if (!isTravIdCurrent(lit_id(lit)) || !isTravIdCurrent(lit_id(a)) || !isTravIdCurrent(lit_id(b)))
+                return;
+            a = map(a);
+            b = map(b);
+            if (a > b) std::swap(a, b);
+            entries.emplace_back(strash_key(a, b), map(lit));
+        });
+        computed_table.clear();
+        StrashTable::Map strash;
+        strash.reserve(entries.size());
+        for (const auto& [key, lit] : entries) strash[key] = lit;
+        computed_table.assign(std::move(strash));
+    }
+    invalidateFanouts();
+}
+
+// 挤掉死槽位，ID 按后序 DFS 恢复成拓扑序。死槽位不够多时仍要检查一遍：
+// 空闲表可能已经被 addAnd 全部用掉 (死节点数为 0)，ID 却已经乱序
+template <class F>
+bool AigGraphT<F>::reclaim(double min_dead_fraction)
+{
+    if (txn_active) throw std::logic_error("reclaim: not allowed inside a transaction");
+    size_t dead = deadCount();
+    if (dead == 0 || dead < min_dead_fraction * nodes.size()) {
+        bool ordered = true;
+        for (size_t id = 1; id < nodes.size() && ordered; ++id) {
+            const AigNode& n = nodes[id];
+            ordered = n.is_input || (lit_id(n.fanin0) < id && lit_id(n.fanin1) < id);
+        }
+        if (ordered) return false;
+    }
+    compact(AigOrder::Dfs);
+    return true;
+}
+
+// =============================================================
+// 按访存局部性重新排列
+// =============================================================
+// 先从输出、再从剩下的 (不可达但没死的) AND 出发做非递归后序 DFS，
+// 得到的序列本身就是拓扑序，也就是 Dfs 排列；travData 顺带记下层级，
+// Level 排列对 DFS 序列按层级做一次稳定的计数排序。
+// -------------------------------------------------------------
+template <class F>
+AigLit AigGraphT<F>::topoOrder(std::vector<AigId>& post) const
+{
+    incTravId();
+    setTravIdCurrent(0);
+    travData(0) = 0;
+    for (AigId id : inputs) {
+        setTravIdCurrent(id);
+        travData(id) = 0;
+    }
+
+    post.clear();
+    AigLit max_level = 0;
+    auto dfs = [&](AigId root) {
+        trav_stack.assign(1, {root, false});
+        while (!trav_stack.empty()) {
+            auto [id, expanded] = trav_stack.back();
+            trav_stack.pop_back();
+            const AigNode& n = nodes[id];
+            if (expanded) {
+                AigLit level = std::max(travData(lit_id(n.fanin0)), travData(lit_id(n.fanin1))) + 1;
+                travData(id) = level;
+                max_level = std::max(max_level, level);
+                post.push_back(id);
+                continue;
+            }
+            if (isTravIdCurrent(id)) continue;
+            setTravIdCurrent(id);
+            trav_stack.push_back({id, true});
+            // fanin1 先压栈，fanin0 先展开
+            for (AigLit f : {n.fanin1, n.fanin0})
+                if (!isTravIdCurrent(lit_id(f))) trav_stack.push_back({lit_id(f), false});
+        }
+    };
+    for (AigLit lit : outputs) dfs(lit_id(lit));
+    for (size_t id = 1; id < nodes.size(); ++id)
+        if (!isDeadNode(nodes[id])) dfs(static_cast<AigId>(id));
+    return max_level;
+}
+
+template <class F>
+void AigGraphT<F>::compact(AigOrder order)
+{
+    if (txn_active) throw std::logic_error("compact: not allowed inside a transaction");
+
+    std::vector<AigId> post;
+    const AigLit max_level = topoOrder(post);
+
+    std::vector<AigId> result;
+    result.reserve(1 + inputs.size() + post.size());
+    result.push_back(0);
+    result.insert(result.end(), inputs.begin(), inputs.end());
+    if (order == AigOrder::Dfs) {
+        result.insert(result.end(), post.begin(), post.end());
+    } else {
+        std::vector<size_t> start(max_level + 2, 0);
+        for (AigId id : post) ++start[travData(id) + 1];
+        for (AigLit l = 1; l <= max_level + 1; ++l) start[l] += start[l - 1];
+        size_t base = result.size();
+        result.resize(base + post.size());
+        for (AigId id : post) result[base + start[travData(id)]++] = id;
+    }
+    renumber(result);
+}
+
+template void AigGraph::buildRefCounts();
+template void AigGraph::deleteUnreferenced();
+template size_t AigGraph::deadCount() const;
+template void AigGraph::renumber(const std::vector<AigId>&);
+template AigLit AigGraph::topoOrder(std::vector<AigId>&) const;
+template bool AigGraph::reclaim(double);
+template void AigGraph::compact(AigOrder);
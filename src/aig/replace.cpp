@@ -0,0 +1,178 @@
+#include "aig.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+// =============================================================
+// 增量扇出索引
+// =============================================================
+// CSR 建好之后的新边记在溢出表里，删掉的边不处理：读取时逐个核对
+// 扇出节点当前的 fanin 是否还指向自己，不指向的就是过期边，直接跳过。
+// 这样 addAnd / replace 只做局部工作，不必每次都重建整张索引。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::addFanoutEdge(AigId from, AigId to) const {
+    if (!fanout_dirty) fanout_extra[from].push_back(to);
+}
+
+template <class F>
+void AigGraphT<F>::collectFanouts(AigId id, std::vector<AigId>& out) const {
+    if (fanout_dirty) buildFanouts();
+    out.clear();
+    auto keep = [&](AigId f) {
+        if (f >= nodes.size()) return;      // 回滚时截掉的节点
+        const AigNode& n = nodes[f];
+        if (!n.is_input && (lit_id(n.fanin0) == id || lit_id(n.fanin1) == id)) out.push_back(f);
+    };
+    if (id + 1 < fanout_start.size())
+        for (size_t k = fanout_start[id]; k < fanout_start[id + 1]; ++k) keep(fanout_ids[k]);
+    auto it = fanout_extra.find(id);
+    if (it != fanout_extra.end())
+        for (AigId f : it->second) keep(f);
+    // 同一条边可能先删后加，在 CSR 和溢出表里各出现一次
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+template <class F>
+void AigGraphT<F>::collectOutputs(AigId id, std::vector<AigId>& out) const {
+    if (fanout_dirty) buildFanouts();
+    out.clear();
+    auto it = output_refs.find(id);
+    if (it == output_refs.end()) return;
+    for (AigId i : it->second)
+        if (i < outputs.size() && lit_id(outputs[i]) == id) out.push_back(i);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// 改写 fanin 并记录新边 (旧边留给读取时校验)；在事务中记入撤销日志
+template <class F>
+void AigGraphT<F>::relink(AigId id, AigLit lit0, AigLit lit1) {
+    if (txn_active)
+        undo_log.push_back({UndoEntry::Fanins, id, nodes[id].fanin0, nodes[id].fanin1, AigKey{}});
+    if (refs_tracked) {
+        // 先加后减：新旧 fanin 相同时计数不会途经 0
+        refInc(lit0);
+        refInc(lit1);
+        refDec(nodes[id].fanin0);
+        refDec(nodes[id].fanin1);
+    }
+    nodes[id].fanin0 = lit0;
+    nodes[id].fanin1 = lit1;
+    addFanoutEdge(lit_id(lit0), id);
+    addFanoutEdge(lit_id(lit1), id);
+}
+
+template <class F>
+void AigGraphT<F>::setOutput(size_t index, AigLit lit) {
+    if (txn_active)
+        undo_log.push_back({UndoEntry::Output, static_cast<AigId>(index), outputs[index], 0, AigKey{}});
+    if (refs_tracked) {
+        refInc(lit);
+        refDec(outputs[index]);
+    }
+    outputs[index] = lit;
+    if (!fanout_dirty) output_refs[lit_id(lit)].push_back(static_cast<AigId>(index));
+}
+
+// =============================================================
+// 节点替换
+// =============================================================
+// 工作表里是 (旧节点, 新字面量)。处理一对时：
+//   1. 旧节点从 strash 摘掉，fanin 清成 (0, 0)，成为死节点
+//   2. 每个扇出节点把对旧节点的引用换成新字面量，然后
+//      - 化简成常量/单个字面量：扇出节点本身也要被替换，入表
+//      - 新的 (fanin0, fanin1) 已有别的节点：与之合并，入表
+//      - 否则原地改写 fanin，以新键重新插入 strash
+//   3. 引用旧节点的 PO 改指新字面量
+// 新字面量本身可能随后被合并掉，用时沿 merged 链解析到最终的字面量。
+// 引用降到 0 的节点等工作表清空之后再删：处理途中某个待用的新字面量
+// 可能暂时没有引用，随后才被扇出接上。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::unhashNode(AigId id) {
+    // 只在 strash 里的记录确实指向 id 时才摘掉 (键可能已经属于合并后的节点)
+    const AigNode& n = nodes[id];
+    AigKey key = strash_key(n.fanin0, n.fanin1);
+    if (computed_table.find(key) == make_lit(id, false)) strashErase(key);
+}
+
+template <class F>
+void AigGraphT<F>::replace(AigId id, AigLit lit)
+{
+    if (id == 0 || id >= nodes.size() || nodes[id].is_input)
+        throw std::out_of_range("replace: not an AND node");
+    if (lit_id(lit) >= nodes.size())
+        throw std::out_of_range("replace: literal refers to nonexistent node");
+
+    if (!refs_tracked) buildRefCounts();
+    ensureStrash();
+
+    std::unordered_map<AigId, AigLit> merged;
+    auto resolve = [&](AigLit l) {
+        for (auto it = merged.find(lit_id(l)); it != merged.end(); it = merged.find(lit_id(l)))
+            l = it->second ^ lit_inv(l);
+        return l;
+    };
+
+    std::vector<std::pair<AigId, AigLit>> work{{id, lit}};
+    std::vector<AigId> fos, pos;
+    while (!work.empty()) {
+        auto [old_id, new_lit] = work.back();
+        work.pop_back();
+        new_lit = resolve(new_lit);
+        if (merged.count(old_id)) continue;
+        if (lit_id(new_lit) == old_id)
+            throw std::logic_error("replace: replacement depends on the replaced node");
+
+        // 1. 先取扇出，再把旧节点变成死节点
+        collectFanouts(old_id, fos);
+        collectOutputs(old_id, pos);
+        unhashNode(old_id);
+        relink(old_id, 0, 0);
+        free_ids.push_back(old_id);
+        merged[old_id] = new_lit;
+
+        // 2. 改写扇出
+        for (AigId f : fos) {
+            if (merged.count(f)) continue;
+            unhashNode(f);
+            AigLit a = nodes[f].fanin0, b = nodes[f].fanin1;
+            if (lit_id(a) == old_id) a = new_lit ^ lit_inv(a);
+            if (lit_id(b) == old_id) b = new_lit ^ lit_inv(b);
+
+            AigLit res = kAigNone;
+            if (a == 0 || b == 0) res = 0;
+            else if (a == 1) res = b;
+            else if (b == 1) res = a;
+            else if (a == b) res = a;
+            else if (a == (b ^ 1)) res = 0;
+            if (res != kAigNone) {
+                work.emplace_back(f, res);
+                continue;
+            }
+
+            if (a > b) std::swap(a, b);
+            AigLit hit = computed_table.find(strash_key(a, b));
+            if (hit != StrashTable::kNone && lit_id(hit) != f) {
+                work.emplace_back(f, hit);
+                continue;
+            }
+            relink(f, a, b);
+            strashInsert(strash_key(a, b), make_lit(f, false));
+        }
+
+        // 3. 改写 PO
+        for (AigId i : pos) setOutput(i, new_lit ^ lit_inv(outputs[i]));
+    }
+    deleteUnreferenced();
+}
+
+template void AigGraph::addFanoutEdge(AigId, AigId) const;
+template void AigGraph::collectFanouts(AigId, std::vector<AigId>&) const;
+template void AigGraph::collectOutputs(AigId, std::vector<AigId>&) const;
+template void AigGraph::relink(AigId, AigLit, AigLit);
+template void AigGraph::setOutput(size_t, AigLit);
+template void AigGraph::unhashNode(AigId);
+template void AigGraph::replace(AigId, AigLit);
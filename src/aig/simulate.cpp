@@ -0,0 +1,30 @@
+#include "aig.h"
+#include <stdexcept>
+
+// =============================================================
+// 64 路并行仿真
+// =============================================================
+// 每个节点一个 64 位字，按 ID 顺序一遍算完；常量 0 为全 0。
+// 访问模式只取决于 fanin 与节点的 ID 距离，compact() 的基准测试用它衡量局部性。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::simulate(const std::vector<uint64_t>& input_words, std::vector<uint64_t>& values) const
+{
+    if (input_words.size() != inputs.size())
+        throw std::invalid_argument("simulate: expected one word per input");
+    const size_t N = nodes.size();
+    values.assign(N, 0);
+    for (size_t k = 0; k < inputs.size(); ++k) values[inputs[k]] = input_words[k];
+
+    auto word = [&](AigLit lit) { return lit_inv(lit) ? ~values[lit_id(lit)] : values[lit_id(lit)]; };
+    for (size_t id = 1; id < N; ++id) {
+        const AigNode& n = nodes[id];
+        if (n.is_input) continue;
+        if (lit_id(n.fanin0) >= id || lit_id(n.fanin1) >= id)
+            throw std::logic_error("simulate: node ids are not in topological order (call reclaim() or compact() first)");
+        values[id] = word(n.fanin0) & word(n.fanin1);
+    }
+}
+
+template void AigGraph::simulate(const std::vector<uint64_t>&, std::vector<uint64_t>&) const;
+template void AigPlainGraph::simulate(const std::vector<uint64_t>&, std::vector<uint64_t>&) const;
@@ -0,0 +1,184 @@
+#include "aig.h"
+#include "mapped_file.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// =============================================================
+// 二进制快照
+// =============================================================
+// 文件布局 (本机字节序，各段起点按页对齐)：
+//   SnapshotHeader
+//   节点段：ceil(num_nodes / kChunkSize) 个块，每块 kChunkBytes 字节，
+//           就是 NodeStore 块在内存里的样子 (最后一块不满的部分补 0)
+//   输入段：num_inputs 个 AigId
+//   输出段：num_outputs 个 AigLit
+// 读回时整个文件只读 mmap，节点块经 NodeStore::adopt 直接引用映射的页，
+// 输入 / 输出是两次 memcpy。映射由节点块共同持有，图和它的副本都不再
+// 引用任何一块之后才解除。
+// 头里记下字面量宽度和节点排列，构建选项不同的程序读到时直接拒绝，
+// 不做转换。格式变化时递增 kSnapshotVersion。
+// 读回时不信任文件内容：段表的每个范围都按不会溢出的方式核对，节点段逐个
+// 做 bulkLoad 同样的检查 (AND 规范、fanin 在节点之前，所以也没有死节点)，
+// 损坏的文件只会被拒绝，不会让后面的遍历越界。
+// -------------------------------------------------------------
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'A', 'I', 'G', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr uint64_t kSectionAlign = 4096;
+
+#ifdef AIG_SOA_NODES
+constexpr uint32_t kNodeLayout = 1;
+#else
+constexpr uint32_t kNodeLayout = 0;
+#endif
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t lit_bytes;         // sizeof(AigLit)
+    uint32_t node_layout;       // 0 = 每节点一个结构体，1 = 按字段分数组
+    uint32_t chunk_size;        // 每块节点数
+    uint64_t chunk_bytes;       // 每块字节数
+    uint64_t num_nodes, num_inputs, num_outputs;
+    uint64_t nodes_offset, inputs_offset, outputs_offset;
+    uint64_t file_size;
+};
+
+uint64_t alignUp(uint64_t x) { return (x + kSectionAlign - 1) & ~(kSectionAlign - 1); }
+
+} // namespace
+
+template <class F>
+void AigGraphT<F>::saveSnapshot(const std::string& path) const
+{
+    // 读回时的检查要求没有死节点、ID 是拓扑序；写出之前先拒绝
+    for (AigId id = 1; id < nodes.size(); ++id) {
+        const AigNode& n = nodes[id];
+        if (!n.is_input && (isDeadNode(n) || lit_id(n.fanin0) >= id || lit_id(n.fanin1) >= id))
+            throw std::logic_error("saveSnapshot: graph has dead or out-of-order nodes (call reclaim() first)");
+    }
+
+    SnapshotHeader h{};
+    std::memcpy(h.magic, kSnapshotMagic, sizeof(h.magic));
+    h.version = kSnapshotVersion;
+    h.lit_bytes = sizeof(AigLit);
+    h.node_layout = kNodeLayout;
+    h.chunk_size = NodeStore::kChunkSize;
+    h.chunk_bytes = NodeStore::kChunkBytes;
+    h.num_nodes = nodes.size();
+    h.num_inputs = inputs.size();
+    h.num_outputs = outputs.size();
+    h.nodes_offset = alignUp(sizeof(h));
+    h.inputs_offset = alignUp(h.nodes_offset + nodes.chunkCount() * h.chunk_bytes);
+    h.outputs_offset = alignUp(h.inputs_offset + inputs.size() * sizeof(AigId));
+    h.file_size = h.outputs_offset + outputs.size() * sizeof(AigLit);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("saveSnapshot: cannot open " + path);
+    auto write_at = [&](uint64_t offset, const void* data, size_t bytes) {
+        static const char zeros[kSectionAlign] = {};
+        for (uint64_t pos = out.tellp(); pos < offset;) {
+            size_t pad = static_cast<size_t>(std::min<uint64_t>(offset - pos, kSectionAlign));
+            out.write(zeros, pad);
+            pos += pad;
+        }
+        out.write(static_cast<const char*>(data), bytes);
+    };
+    write_at(0, &h, sizeof(h));
+    for (size_t c = 0; c < nodes.chunkCount(); ++c)
+        write_at(h.nodes_offset + c * h.chunk_bytes, nodes.chunkData(c), h.chunk_bytes);
+    write_at(h.inputs_offset, inputs.data(), inputs.size() * sizeof(AigId));
+    write_at(h.outputs_offset, outputs.data(), outputs.size() * sizeof(AigLit));
+    if (!out.flush()) throw std::runtime_error("saveSnapshot: write to " + path + " failed");
+}
+
+template <class F>
+void AigGraphT<F>::loadSnapshot(const std::string& path)
+{
+    if (txn_active) throw std::logic_error("loadSnapshot: not allowed inside a transaction");
+    if (conc) throw std::logic_error("loadSnapshot: not allowed during concurrent construction");
+
+    auto map = std::make_shared<MappedFile>();
+    if (!map->open(path)) throw std::runtime_error("loadSnapshot: cannot map " + path);
+
+    auto fail = [&](const char* what) { throw std::runtime_error("loadSnapshot: " + path + ": " + what); };
+    const char* base = map->data();
+    SnapshotHeader h;
+    if (map->size() < sizeof(h)) fail("file too short");
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, kSnapshotMagic, sizeof(h.magic)) != 0) fail("not a snapshot");
+    if (h.version != kSnapshotVersion) fail("unsupported snapshot version");
+    if (h.lit_bytes != sizeof(AigLit) || h.node_layout != kNodeLayout ||
+        h.chunk_size != NodeStore::kChunkSize || h.chunk_bytes != NodeStore::kChunkBytes)
+        fail("written by a build with a different literal width or node layout");
+    // [offset, offset + count * size) 落在 [0, end) 之内；各项都来自文件，按不溢出的方式比较
+    auto fits = [](uint64_t offset, uint64_t count, uint64_t size, uint64_t end) {
+        return offset <= end && count <= (end - offset) / size;
+    };
+    const uint64_t nchunks = h.num_nodes / h.chunk_size + (h.num_nodes % h.chunk_size != 0);
+    if (h.num_nodes == 0 || h.num_nodes > (kAigNone >> 1) || h.file_size != map->size() ||
+        h.nodes_offset % kSectionAlign != 0 ||
+        !fits(h.nodes_offset, nchunks, h.chunk_bytes, h.inputs_offset) ||
+        !fits(h.inputs_offset, h.num_inputs, sizeof(AigId), h.outputs_offset) ||
+        !fits(h.outputs_offset, h.num_outputs, sizeof(AigLit), h.file_size))
+        fail("corrupt section table");
+
+    std::vector<AigId> new_inputs(h.num_inputs);
+    std::vector<AigLit> new_outputs(h.num_outputs);
+    std::memcpy(new_inputs.data(), base + h.inputs_offset, new_inputs.size() * sizeof(AigId));
+    std::memcpy(new_outputs.data(), base + h.outputs_offset, new_outputs.size() * sizeof(AigLit));
+    for (AigLit lit : new_outputs)
+        if (lit_id(lit) >= h.num_nodes) fail("output literal out of range");
+
+    // 节点段：常量节点不是输入；AND 的检查同 bulkLoad，每个节点 O(1)
+    NodeStore fresh;
+    fresh.adopt(map, base + h.nodes_offset, h.num_nodes);
+    const NodeStore& view = fresh;      // 只读，不触发写时复制
+    if (view[0].is_input) fail("corrupt node section");
+    uint64_t input_nodes = 0;
+    for (AigId id = 1; id < h.num_nodes; ++id) {
+        const AigNode n = view[id];
+        if (n.is_input) {
+            ++input_nodes;
+            continue;
+        }
+        AigLit a = n.fanin0, b = n.fanin1;
+        if (a > b) std::swap(a, b);
+        if (a < 2 || lit_id(a) == lit_id(b) || lit_id(b) >= id) fail("corrupt node section");
+    }
+
+    // 输入段恰好列出所有输入节点，每个一次
+    std::vector<char> listed(h.num_nodes, 0);
+    for (AigId id : new_inputs) {
+        if (id == 0 || id >= h.num_nodes) fail("input id out of range");
+        if (!view[id].is_input || listed[id]) fail("input list does not match the node section");
+        listed[id] = 1;
+    }
+    if (input_nodes != h.num_inputs) fail("input list does not match the node section");
+
+    nodes.swap(fresh);
+    inputs = std::move(new_inputs);
+    outputs = std::move(new_outputs);
+    computed_table.clear();
+    strash_stale = F::kStrash;
+    free_ids.clear();
+    invalidateFanouts();
+}
+
+template <class F>
+bool AigGraphT<F>::isSnapshot(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kSnapshotMagic)] = {};
+    in.read(magic, sizeof(magic));
+    return in && std::memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0;
+}
+
+template void AigGraph::saveSnapshot(const std::string&) const;
+template void AigGraph::loadSnapshot(const std::string&);
+template bool AigGraph::isSnapshot(const std::string&);
+template void AigPlainGraph::saveSnapshot(const std::string&) const;
+template void AigPlainGraph::loadSnapshot(const std::string&);
+template bool AigPlainGraph::isSnapshot(const std::string&);
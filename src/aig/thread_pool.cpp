@@ -0,0 +1,121 @@
+#include "thread_pool.h"
+
+// =============================================================
+// 临时内存区
+// =============================================================
+void* ScratchArena::raw(size_t bytes, size_t align) {
+    for (;;) {
+        if (cur < blocks.size()) {
+            size_t p = (off + align - 1) & ~(align - 1);
+            if (p + bytes <= sizes[cur]) {
+                off = p + bytes;
+                return blocks[cur].get() + p;
+            }
+            // 当前块放不下，换下一块 (已有的块按顺序复用)
+            ++cur;
+            off = 0;
+            continue;
+        }
+        size_t sz = std::max(kBlockSize, bytes + align);
+        blocks.emplace_back(new unsigned char[sz]);
+        sizes.push_back(sz);
+    }
+}
+
+// =============================================================
+// 工作窃取线程池
+// =============================================================
+namespace {
+// 当前线程所属的池和在池中的编号
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local unsigned tls_index = 0;
+}
+
+ThreadPool::ThreadPool(unsigned threads) : capacity(std::max(1u, threads)) {
+    for (unsigned i = 0; i < capacity; ++i)
+        slots.emplace_back(new Slot);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(sleep_m);
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+unsigned ThreadPool::workerIndex() const {
+    return tls_pool == this ? tls_index : 0;
+}
+
+ScratchArena& ThreadPool::arena() {
+    if (tls_pool == this) return slots[tls_index]->arena;
+    static thread_local ScratchArena external;
+    return external;
+}
+
+void ThreadPool::ensureStarted() {
+    // 串行运行从不提交任务，也就从不创建线程
+    std::lock_guard<std::mutex> lk(start_m);
+    if (!workers.empty()) return;
+    for (unsigned i = 1; i < capacity; ++i)
+        workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+void ThreadPool::push(Task task) {
+    ensureStarted();
+    Slot& s = *slots[workerIndex()];
+    queued.fetch_add(1);    // 先计数再入队，计数不会短暂变成负数
+    {
+        std::lock_guard<std::mutex> lk(s.m);
+        s.q.push_back(std::move(task));
+    }
+    wakeAll();
+}
+
+void ThreadPool::wakeAll() {
+    // 先拿一下 sleep_m 再通知，避免对方检查完条件、还没睡下时丢失唤醒
+    { std::lock_guard<std::mutex> lk(sleep_m); }
+    sleep_cv.notify_all();
+}
+
+bool ThreadPool::runOne(unsigned self) {
+    Task task;
+    {
+        Slot& s = *slots[self];
+        std::lock_guard<std::mutex> lk(s.m);
+        if (!s.q.empty()) {
+            task = std::move(s.q.back());
+            s.q.pop_back();
+        }
+    }
+    for (unsigned k = 1; !task && k < capacity; ++k) {
+        Slot& s = *slots[(self + k) % capacity];
+        std::lock_guard<std::mutex> lk(s.m);
+        if (!s.q.empty()) {
+            task = std::move(s.q.front());
+            s.q.pop_front();
+        }
+    }
+    if (!task) return false;
+    queued.fetch_sub(1);
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    tls_pool = this;
+    tls_index = index;
+    for (;;) {
+        if (runOne(index)) continue;
+        std::unique_lock<std::mutex> lk(sleep_m);
+        sleep_cv.wait(lk, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
@@ -0,0 +1,136 @@
+#include "aig.h"
+#include <stdexcept>
+
+// =============================================================
+// 原地改写 fanin
+// =============================================================
+template <class F>
+void AigGraphT<F>::setFanins(AigId id, AigLit lit0, AigLit lit1) {
+    if (id >= nodes.size() || nodes[id].is_input || id == 0)
+        throw std::out_of_range("setFanins: not an AND node");
+    if (txn_active)
+        undo_log.push_back({UndoEntry::Fanins, id, nodes[id].fanin0, nodes[id].fanin1, AigKey{}});
+    nodes[id].fanin0 = lit0;
+    nodes[id].fanin1 = lit1;
+    invalidateFanouts();
+}
+
+// =============================================================
+// strash 修改 (经由这里才能被撤销)
+// =============================================================
+template <class F>
+void AigGraphT<F>::strashInsert(const AigKey& key, AigLit lit) {
+    ensureStrash();
+    if (txn_active) undo_log.push_back({UndoEntry::StrashInsert, 0, 0, 0, key});
+    computed_table.insert(key, lit);
+}
+
+template <class F>
+void AigGraphT<F>::strashErase(const AigKey& key) {
+    ensureStrash();
+    AigLit old = computed_table.find(key);
+    if (old == StrashTable::kNone) return;
+    if (txn_active) undo_log.push_back({UndoEntry::StrashErase, old, 0, 0, key});
+    computed_table.erase(key);
+}
+
+// =============================================================
+// 事务
+// =============================================================
+// 新增的节点、输入、输出只会追加在末尾，记下开始时的长度即可；
+// 其余改动逐条记录，回滚时逆序恢复。
+// 引用计数的增减完全由 fanin / PO 的改动决定，恢复每条改动时反向增减一次即可；
+// 事务中 addAnd 不复用空闲槽位，空闲表只会追加，截回开始时的长度。
+// 扇出索引本来就容忍过期边，恢复出的旧边重新记进溢出表，指向被截掉节点的边
+// 在读取时跳过。事务中途 invalidateFanouts() 过 (setFanins、addInput 等)
+// 就没法这样恢复，回滚后仍然整体作废，用到时重建。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::beginTransaction() {
+    if (txn_active) throw std::logic_error("beginTransaction: nested transactions are not supported");
+    txn_active = true;
+    txn_nodes = nodes.size();
+    txn_inputs = inputs.size();
+    txn_outputs = outputs.size();
+    txn_free = free_ids.size();
+    txn_refs = refs_tracked;
+    txn_fanouts = !fanout_dirty;
+    txn_incremental = true;
+    undo_log.clear();
+}
+
+template <class F>
+void AigGraphT<F>::commitTransaction() {
+    if (!txn_active) throw std::logic_error("commitTransaction: no active transaction");
+    txn_active = false;
+    undo_log.clear();
+}
+
+template <class F>
+void AigGraphT<F>::rollbackTransaction() {
+    if (!txn_active) throw std::logic_error("rollbackTransaction: no active transaction");
+    const bool refs_ok = txn_incremental && txn_refs && refs_tracked;
+    const bool fanouts_ok = txn_incremental && txn_fanouts && !fanout_dirty;
+    if (!refs_ok) refs_tracked = false;
+    if (!fanouts_ok) fanout_dirty = true;
+
+    for (auto it = undo_log.rbegin(); it != undo_log.rend(); ++it) {
+        switch (it->kind) {
+        case UndoEntry::Fanins: {
+            AigId id = static_cast<AigId>(it->id);
+            AigLit cur0 = nodes[id].fanin0, cur1 = nodes[id].fanin1;
+            nodes[id].fanin0 = it->fanin0;
+            nodes[id].fanin1 = it->fanin1;
+            if (refs_ok) {
+                refInc(it->fanin0);
+                refInc(it->fanin1);
+                refDec(cur0);
+                refDec(cur1);
+            }
+            addFanoutEdge(lit_id(it->fanin0), id);
+            addFanoutEdge(lit_id(it->fanin1), id);
+            break;
+        }
+        case UndoEntry::StrashInsert:
+            computed_table.erase(it->key);
+            break;
+        case UndoEntry::StrashErase:
+            computed_table.insert(it->key, it->id);
+            break;
+        case UndoEntry::Output:
+            if (refs_ok) {
+                refInc(it->fanin0);
+                refDec(outputs[it->id]);
+            }
+            outputs[it->id] = it->fanin0;
+            if (fanouts_ok) output_refs[lit_id(it->fanin0)].push_back(static_cast<AigId>(it->id));
+            break;
+        }
+    }
+
+    // 追加的节点和 PO 去掉之前，先收回它们对原有节点的引用
+    if (refs_ok) {
+        for (size_t i = txn_outputs; i < outputs.size(); ++i) refDec(outputs[i]);
+        for (size_t id = txn_nodes; id < nodes.size(); ++id) {
+            const AigNode& n = nodes[id];
+            if (n.is_input || isDeadNode(n)) continue;
+            refDec(n.fanin0);
+            refDec(n.fanin1);
+        }
+        ref_count.resize(txn_nodes);
+        free_ids.resize(txn_free);
+    }
+    ref_zero.clear();       // 恢复出来的引用关系里没有要删的节点
+    nodes.resize(txn_nodes);
+    inputs.resize(txn_inputs);
+    outputs.resize(txn_outputs);
+    txn_active = false;
+    undo_log.clear();
+}
+
+template void AigGraph::setFanins(AigId, AigLit, AigLit);
+template void AigGraph::strashInsert(const AigKey&, AigLit);
+template void AigGraph::strashErase(const AigKey&);
+template void AigGraph::beginTransaction();
+template void AigGraph::commitTransaction();
+template void AigGraph::rollbackTransaction();
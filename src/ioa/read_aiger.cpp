@@ -1,9 +1,13 @@
 #include "aig.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
 #include <fstream>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
 // ---------------------------------------------------------------------
 // 辅助函数：AIGER Literal -> Internal AigGraph Literal
@@ -11,8 +15,8 @@
 // aiger_lit: AIGER文件中的字面量 (偶数=原变量, 奇数=反相)
 // table:     映射表 [AIGER_VAR_INDEX] -> Internal_Literal (Positive)
 // ---------------------------------------------------------------------
-static uint32_t resolve_lit(uint32_t aiger_lit, const std::vector<uint32_t>& table) {
-    uint32_t var_idx = aiger_lit >> 1;
+static AigLit resolve_lit(AigLit aiger_lit, const std::vector<AigLit>& table) {
+    AigLit var_idx = aiger_lit >> 1;
     bool is_inv = aiger_lit & 1;
 
     // table 存储的是该变量对应的 "正相" 内部 literal
@@ -21,7 +25,200 @@ static uint32_t resolve_lit(uint32_t aiger_lit, const std::vector<uint32_t>& tab
     return table[var_idx] ^ is_inv;
 }
 
-bool read_aiger_file(const std::string& filename, AigGraph& aig) {
+// ---------------------------------------------------------------------
+// AND 段的读取
+// ---------------------------------------------------------------------
+// parse_threads == 0 时直接从流里逐个读。否则把文件只读映射，从流当前的
+// 位置 (输出段之后) 开始按窗口处理：每个窗口在换行处切成 parse_threads 份，
+// 各线程把自己那份的整数解码进自己的数组，之后调用方按原顺序逐个取出，
+// 字面量映射和 strash 仍然只在一个线程里做。每个门占一行，所以切在换行处
+// 的每一份都是整数个三元组；碰到不是数字的内容 (符号表、注释) 就停下。
+// 窗口限制了解码数组的大小，读大文件时不会多占一份和文件同量级的内存。
+// ---------------------------------------------------------------------
+class AndReader {
+public:
+    AndReader(std::istream& fin, const std::string& filename, unsigned parse_threads)
+        : fin(fin), threads(parse_threads) {
+        if (threads == 0) return;
+        if (!file.open(filename)) {
+            threads = 0;        // 映射不了就退回逐个读
+            return;
+        }
+        std::streamoff off = fin.tellg();
+        cur = file.data() + std::min<size_t>(off < 0 ? file.size() : static_cast<size_t>(off), file.size());
+        end = file.data() + file.size();
+    }
+
+    // 取下一个门；文件提前结束或格式不对时报错并返回 false
+    bool next(AigLit& lhs, AigLit& rhs0, AigLit& rhs1) {
+        bool ok = threads == 0 ? static_cast<bool>(fin >> lhs >> rhs0 >> rhs1) : take(lhs, rhs0, rhs1);
+        if (!ok) std::cerr << "Error: AND section ends or is malformed at gate " << count << std::endl;
+        ++count;
+        return ok;
+    }
+
+private:
+    static constexpr size_t kWindowBytes = size_t(32) << 20;
+
+    struct Part {
+        std::vector<AigLit> lits;       // lhs, rhs0, rhs1 依次排列
+        bool halted = false;            // 碰到了非数字内容，后面的份不再有 AND
+    };
+
+    bool take(AigLit& lhs, AigLit& rhs0, AigLit& rhs1) {
+        while (part == parts.size() || pos == parts[part].lits.size()) {
+            if (part < parts.size()) {
+                if (parts[part].halted) return false;
+                ++part;
+                pos = 0;
+            } else if (!fill()) {
+                return false;
+            }
+        }
+        const AigLit* t = parts[part].lits.data() + pos;
+        lhs = t[0];
+        rhs0 = t[1];
+        rhs1 = t[2];
+        pos += 3;
+        return true;
+    }
+
+    static const char* afterNewline(const char* p, const char* stop) {
+        const void* nl = std::memchr(p, '\n', static_cast<size_t>(stop - p));
+        return nl ? static_cast<const char*>(nl) + 1 : stop;
+    }
+
+    // 解码下一个窗口
+    bool fill() {
+        if (cur == end) return false;
+        const char* stop = cur + std::min(kWindowBytes, static_cast<size_t>(end - cur));
+        if (stop != end) stop = afterNewline(stop, end);
+
+        std::vector<const char*> cuts{cur};
+        for (unsigned t = 1; t < threads; ++t) {
+            const char* p = std::max(cur + static_cast<size_t>(stop - cur) * t / threads, cuts.back());
+            cuts.push_back(p == cur ? cur : afterNewline(p - 1, stop));
+        }
+        cuts.push_back(stop);
+
+        parts.assign(threads, Part{});
+        ThreadPool::global().parallel_for(0, threads, 1, threads, [&](size_t lo, size_t hi) {
+            for (size_t k = lo; k < hi; ++k) decode(cuts[k], cuts[k + 1], parts[k]);
+        });
+        part = 0;
+        pos = 0;
+        cur = stop;
+        return true;
+    }
+
+    static void decode(const char* p, const char* stop, Part& out) {
+        out.lits.reserve(static_cast<size_t>(stop - p) / 4);
+        while (p < stop) {
+            char c = *p;
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                ++p;
+                continue;
+            }
+            if (c < '0' || c > '9') {
+                out.halted = true;
+                break;
+            }
+            // 超出 AigLit 的数按格式错误处理 (同流式读取时 >> 置 failbit)
+            AigLit v = 0;
+            bool overflow = false;
+            for (; p < stop && *p >= '0' && *p <= '9'; ++p) {
+                AigLit d = static_cast<AigLit>(*p - '0');
+                if (v > (kAigNone - d) / 10) {
+                    overflow = true;
+                    break;
+                }
+                v = v * 10 + d;
+            }
+            if (overflow) {
+                out.halted = true;
+                break;
+            }
+            out.lits.push_back(v);
+        }
+        if (out.lits.size() % 3 != 0) {
+            out.lits.resize(out.lits.size() / 3 * 3);
+            out.halted = true;
+        }
+    }
+
+    std::istream& fin;
+    unsigned threads;
+    MappedFile file;
+    const char* cur = nullptr;          // 还没解码的部分
+    const char* end = nullptr;
+    std::vector<Part> parts;
+    size_t part = 0, pos = 0;
+    uint64_t count = 0;
+};
+
+// ---------------------------------------------------------------------
+// 可信模式：标准编号的文件 (输入 1..I，latch I+1..I+L，AND 依次往后) 里
+// AIGER 字面量就是内部字面量，不需要映射表，AND 边读边分块交给 bulkLoad
+// ---------------------------------------------------------------------
+template <class F>
+static bool read_trusted(std::istream& fin, const std::string& filename, unsigned parse_threads,
+                         uint64_t I, uint64_t L, uint64_t O, uint64_t A, AigGraphT<F>& aig) {
+    if (aig.nodes.size() != 1) {
+        std::cerr << "Error: trusted read needs an empty graph" << std::endl;
+        return false;
+    }
+    auto expect = [](AigLit lhs, uint64_t var) {
+        if (lhs == 2 * var) return true;
+        std::cerr << "Error: literal " << lhs << " breaks the standard numbering (expected "
+                  << 2 * var << "), read the file without trusted mode" << std::endl;
+        return false;
+    };
+
+    for (uint64_t i = 0; i < I; ++i) {
+        AigLit lit;
+        fin >> lit;
+        if (!expect(lit, 1 + i)) return false;
+        aig.addInput();
+    }
+    for (uint64_t i = 0; i < L; ++i) {
+        AigLit lhs;
+        fin >> lhs;
+        std::string dummy;
+        std::getline(fin, dummy);
+        if (!expect(lhs, 1 + I + i)) return false;
+        aig.addInput();
+    }
+    std::vector<AigLit> output_lits(O);
+    for (uint64_t i = 0; i < O; ++i) {
+        fin >> output_lits[i];
+    }
+
+    AndReader ands(fin, filename, parse_threads);
+    constexpr size_t kChunk = 4096;
+    std::vector<AigLit> fanin0, fanin1;
+    try {
+        for (uint64_t i = 0; i < A; ++i) {
+            AigLit lhs, rhs0, rhs1;
+            if (!ands.next(lhs, rhs0, rhs1) || !expect(lhs, 1 + I + L + i)) return false;
+            fanin0.push_back(rhs0);
+            fanin1.push_back(rhs1);
+            if (fanin0.size() == kChunk) {
+                aig.bulkLoad(fanin0, fanin1);
+                fanin0.clear();
+                fanin1.clear();
+            }
+        }
+        aig.bulkLoad(fanin0, fanin1);
+        for (AigLit lit : output_lits) aig.addOutput(lit);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <class F>
+bool read_aiger_file(const std::string& filename, AigGraphT<F>& aig, bool trusted, unsigned parse_threads) {
     std::ifstream fin(filename);
     if (!fin) {
         std::cerr << "Error: Cannot open file " << filename << std::endl;
@@ -35,24 +232,38 @@ bool read_aiger_file(const std::string& filename, AigGraph& aig) {
         return false;
     }
 
-    uint32_t M, I, L, O, A;
+    uint64_t M, I, L, O, A;
     fin >> M >> I >> L >> O >> A;
 
+    // 内部 ID 上限：2 * ID + 1 要放得进 AigLit，kAigNone 保留
+    if (M >= (kAigNone >> 1)) {
+        std::cerr << "Error: M = " << M << " exceeds the " << sizeof(AigLit) * 8
+                  << "-bit literal range (rebuild with -DAIG_LIT64=ON)" << std::endl;
+        return false;
+    }
+    if (trusted) return read_trusted(fin, filename, parse_threads, I, L, O, A, aig);
+
     // -------------------------------------------------------
     // 映射表初始化
     // AIGER 变量索引从 0 到 M。
     // Index 0 固定为常量 False (对应内部 literal 0)
     // -------------------------------------------------------
-    std::vector<uint32_t> aiger2lit(M + 1, 0); 
+    std::vector<AigLit> aiger2lit(M + 1, 0); 
+    auto in_range = [&](AigLit lit) {
+        if ((lit >> 1) <= M) return true;
+        std::cerr << "Error: literal " << lit << " exceeds M = " << M << std::endl;
+        return false;
+    };
 
     // -------------------------------------------------------
     // 1. 读取 Inputs
     // -------------------------------------------------------
-    for (uint32_t i = 0; i < I; ++i) {
-        uint32_t lit;
+    for (uint64_t i = 0; i < I; ++i) {
+        AigLit lit;
         fin >> lit; // 读取 input literal (通常是偶数)
-        
-        uint32_t id = aig.addInput();
+        if (!in_range(lit)) return false;
+
+        AigId id = aig.addInput();
         // 记录映射: AIGER Var -> Internal Literal (make_lit(id, 0))
         aiger2lit[lit >> 1] = make_lit(id, false);
     }
@@ -62,15 +273,16 @@ bool read_aiger_file(const std::string& filename, AigGraph& aig) {
     // -------------------------------------------------------
     // 格式: "lhs next_state [reset]"
     // 我们只关心 lhs (当前状态输出)，将其视为电路的一个输入
-    for (uint32_t i = 0; i < L; ++i) {
-        uint32_t lhs;
+    for (uint64_t i = 0; i < L; ++i) {
+        AigLit lhs;
         fin >> lhs;
         
         // 跳过这一行的剩余部分 (next_state 等)
         std::string dummy;
         std::getline(fin, dummy);
+        if (!in_range(lhs)) return false;
 
-        uint32_t id = aig.addInput();
+        AigId id = aig.addInput();
         aiger2lit[lhs >> 1] = make_lit(id, false);
     }
 
@@ -78,38 +290,62 @@ bool read_aiger_file(const std::string& filename, AigGraph& aig) {
     // 3. 读取 Outputs (先缓存)
     // -------------------------------------------------------
     // 注意：此时 Output 引用的 AND 门可能还没创建，所以不能直接 addOutput
-    std::vector<uint32_t> output_lits(O);
-    for (uint32_t i = 0; i < O; ++i) {
+    std::vector<AigLit> output_lits(O);
+    for (uint64_t i = 0; i < O; ++i) {
         fin >> output_lits[i];
+        if (!in_range(output_lits[i])) return false;
     }
 
     // -------------------------------------------------------
     // 4. 读取 AND Gates
     // -------------------------------------------------------
     // AIGER 保证门是拓扑排序的，rhs 引用的变量一定已经定义过 (Input, Latch, 或之前的 AND)
-    for (uint32_t i = 0; i < A; ++i) {
-        uint32_t lhs, rhs0, rhs1;
-        fin >> lhs >> rhs0 >> rhs1;
-
-        // 解析右侧操作数
-        uint32_t l0 = resolve_lit(rhs0, aiger2lit);
-        uint32_t l1 = resolve_lit(rhs1, aiger2lit);
-
-        // 构建 AND 节点
-        // addAnd 会处理简单的常量折叠，并返回结果 Literal
-        uint32_t res_lit = aig.addAnd(l0, l1);
-
+    // 门按批交给 addAndBatch (批内的 strash 查找可以重叠)。
+    // 本批内定义的变量先记成批内序号 make_lit(k)，in_batch 标记这些变量；
+    // 批处理完再换成真正的字面量
+    AndReader ands(fin, filename, parse_threads);
+    constexpr size_t kBatch = 1024;
+    std::vector<std::pair<AigLit, AigLit>> batch;
+    std::vector<uint8_t> batch_refs;
+    std::vector<AigLit> batch_lhs, batch_out;
+    std::vector<bool> in_batch(M + 1, false);
+    auto flush = [&]() {
+        // addAndBatch 会处理简单的常量折叠，并返回结果 Literal
+        aig.addAndBatch(batch, batch_refs, batch_out);
         // 记录映射: AIGER Var (lhs) -> Result Literal
-        aiger2lit[lhs >> 1] = res_lit;
+        for (size_t k = 0; k < batch.size(); ++k) {
+            aiger2lit[batch_lhs[k] >> 1] = batch_out[k];
+            in_batch[batch_lhs[k] >> 1] = false;
+        }
+        batch.clear();
+        batch_refs.clear();
+        batch_lhs.clear();
+    };
+    for (uint64_t i = 0; i < A; ++i) {
+        AigLit lhs, rhs0, rhs1;
+        if (!ands.next(lhs, rhs0, rhs1)) return false;
+        if (!in_range(lhs) || !in_range(rhs0) || !in_range(rhs1)) return false;
+
+        // 解析右侧操作数 (可能是本批内的序号)
+        batch.emplace_back(resolve_lit(rhs0, aiger2lit), resolve_lit(rhs1, aiger2lit));
+        batch_refs.push_back(static_cast<uint8_t>(in_batch[rhs0 >> 1] | in_batch[rhs1 >> 1] << 1));
+        batch_lhs.push_back(lhs);
+        aiger2lit[lhs >> 1] = make_lit(static_cast<AigId>(batch.size() - 1));
+        in_batch[lhs >> 1] = true;
+        if (batch.size() == kBatch) flush();
     }
+    flush();
 
     // -------------------------------------------------------
     // 5. 连接 Outputs
     // -------------------------------------------------------
-    for (uint32_t lit : output_lits) {
+    for (AigLit lit : output_lits) {
         aig.addOutput(resolve_lit(lit, aiger2lit));
     }
 
     // 解析成功 (忽略后续的 Symbol Table 和 Comments)
     return true;
-}
\ No newline at end of file
+}
+
+template bool read_aiger_file(const std::string&, AigGraph&, bool, unsigned);
+template bool read_aiger_file(const std::string&, AigPlainGraph&, bool, unsigned);
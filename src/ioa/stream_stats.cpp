@@ -0,0 +1,135 @@
+#include "aig.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// =============================================================
+// 流式统计：不建图
+// =============================================================
+// 结果与 AigPlainGraph 读入后 stats() 一致，但只保留：
+//   level[v]   每个 AIGER 变量的层级 (未定义的变量记 kUndefined，按常量 0 处理，同读入器)
+//   inv_used   每个变量的反相形式是否已经被引用过 (只按变量计一次)
+//   alias      被 addAnd 的规则化简掉的门 -> 等价的字面量；真实网表里很少，用稀疏表
+// 字面量全程按 AIGER 变量编号处理，不分配内部 ID，所以也不受 AigLit 宽度限制。
+// -------------------------------------------------------------
+namespace {
+
+constexpr uint32_t kUndefined = std::numeric_limits<uint32_t>::max();
+
+struct StreamState {
+    std::vector<uint32_t> level;
+    std::vector<bool> inv_used;
+    std::unordered_map<uint64_t, uint64_t> alias;
+    AigStats s;
+
+    // AIGER 字面量 -> 代表它的字面量 (化简掉的门换成等价的字面量，未定义的变量是常量 0)
+    uint64_t resolve(uint64_t lit) const {
+        uint64_t var = lit >> 1;
+        if (level[var] == kUndefined) return lit & 1;
+        auto it = alias.find(var);
+        return it == alias.end() ? lit : it->second ^ (lit & 1);
+    }
+
+    // 同 countInverters：节点的反相形式第一次被引用时计一个反相器
+    void use(uint64_t lit) {
+        if (!(lit & 1) || inv_used[lit >> 1]) return;
+        inv_used[lit >> 1] = true;
+        ++s.inverters;
+    }
+
+    // 同 addAnd 的化简规则；a、b 已经 resolve 过
+    void addAnd(uint64_t var, uint64_t a, uint64_t b) {
+        uint64_t folded;
+        if (a == 0 || b == 0 || a == (b ^ 1)) folded = 0;
+        else if (a == 1 || a == b) folded = b;
+        else if (b == 1) folded = a;
+        else {
+            alias.erase(var);
+            level[var] = std::max(level[a >> 1], level[b >> 1]) + 1;
+            use(a);
+            use(b);
+            ++s.area;
+            return;
+        }
+        alias[var] = folded;
+        level[var] = 0;     // 只要不是 kUndefined，真正的层级看 alias 指向的字面量
+    }
+};
+
+} // namespace
+
+bool stream_aiger_stats(const std::string& filename, AigStats& stats) {
+    std::ifstream fin(filename);
+    if (!fin) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return false;
+    }
+
+    std::string header;
+    fin >> header;
+    if (header != "aag") {
+        std::cerr << "Error: Invalid header '" << header << "', expected 'aag'" << std::endl;
+        return false;
+    }
+
+    uint64_t M, I, L, O, A;
+    fin >> M >> I >> L >> O >> A;
+    if (!fin) {
+        std::cerr << "Error: Malformed header in " << filename << std::endl;
+        return false;
+    }
+
+    StreamState st;
+    st.level.assign(M + 1, kUndefined);
+    st.inv_used.assign(M + 1, false);
+    st.level[0] = 0;
+    auto check = [&](uint64_t lit) {
+        if ((lit >> 1) <= M) return true;
+        std::cerr << "Error: literal " << lit << " exceeds M = " << M << std::endl;
+        return false;
+    };
+
+    // 输入和 latch 都是层级 0 的 (伪) 输入
+    for (uint64_t i = 0; i < I + L; ++i) {
+        uint64_t lit;
+        fin >> lit;
+        if (!check(lit)) return false;
+        if (i >= I) {
+            std::string dummy;
+            std::getline(fin, dummy);
+        }
+        st.level[lit >> 1] = 0;
+    }
+
+    // 输出引用的门还没读到，先缓存
+    std::vector<uint64_t> output_lits(O);
+    for (uint64_t i = 0; i < O; ++i) {
+        fin >> output_lits[i];
+        if (!check(output_lits[i])) return false;
+    }
+
+    for (uint64_t i = 0; i < A; ++i) {
+        uint64_t lhs, rhs0, rhs1;
+        fin >> lhs >> rhs0 >> rhs1;
+        if (!check(lhs) || !check(rhs0) || !check(rhs1)) return false;
+        st.addAnd(lhs >> 1, st.resolve(rhs0), st.resolve(rhs1));
+    }
+    if (!fin) {
+        std::cerr << "Error: Unexpected end of file in " << filename << std::endl;
+        return false;
+    }
+
+    for (uint64_t lit : output_lits) {
+        uint64_t r = st.resolve(lit);
+        st.use(r);
+        st.s.depth = std::max(st.s.depth, st.level[r >> 1]);
+    }
+    st.s.pis = I + L;
+    st.s.pos = O;
+    stats = st.s;
+    return true;
+}
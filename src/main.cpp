@@ -1,20 +1,178 @@
 #include "aig.h"
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [-j threads] [--levelized] [--partitions N]\n"
+              << "       [--portfolio N] [--script S]... [--objective area|depth|not|mix[:wa,wd,wn]]\n"
+              << "       [--bench-order] [--stats] [--stats-stream] [--trusted]\n"
+              << "       [--parallel-parse] [--save-snapshot F] file\n";
+}
+
+// 输入可以是 AIGER 文本，也可以是 saveSnapshot 写出的快照
+template <class G>
+static bool loadGraph(const char* file, G& g, bool trusted, unsigned parse_threads) {
+    if (!G::isSnapshot(file)) return read_aiger_file(file, g, trusted, parse_threads);
+    try {
+        g.loadSnapshot(file);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// 存的是读进来的图，之后可以直接用快照代替原文件
+template <class G>
+static bool saveGraph(const G& g, const std::string& path) {
+    if (path.empty()) return true;
+    try {
+        g.saveSnapshot(path);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// 同一张图在不同节点排列下的遍历 / 仿真 / 深度耗时 (毫秒)
+static void benchOrders(const AigGraph& aig) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::time_point t0) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    };
+    constexpr int kRounds = 16;
+
+    std::printf("\n%-6s %10s %10s %10s %10s\n", "order", "compact", "traverse", "simulate", "depth");
+    const char* names[] = {"none", "dfs", "level"};
+    for (int k = 0; k < 3; ++k) {
+        AigGraph g = aig;
+        auto t0 = Clock::now();
+        if (k == 1) g.compact(AigOrder::Dfs);
+        if (k == 2) g.compact(AigOrder::Level);
+        double t_compact = ms(t0);
+
+        // 遍历：重建扇出索引并走一遍所有扇出
+        t0 = Clock::now();
+        for (int r = 0; r < kRounds; ++r) {
+            g.invalidateFanouts();
+            for (AigId id = 0; id < g.nodes.size(); ++id) g.fanoutCount(id);
+        }
+        double t_trav = ms(t0);
+
+        std::mt19937_64 rng(1);
+        std::vector<uint64_t> words(g.inputs.size()), values;
+        t0 = Clock::now();
+        for (int r = 0; r < kRounds; ++r) {
+            for (uint64_t& w : words) w = rng();
+            g.simulate(words, values);
+        }
+        double t_sim = ms(t0);
+
+        t0 = Clock::now();
+        uint32_t d = 0;
+        for (int r = 0; r < kRounds; ++r) d = std::max(d, g.depth());
+        double t_depth = ms(t0);
+
+        std::printf("%-6s %10.2f %10.2f %10.2f %10.2f\n", names[k], t_compact, t_trav, t_sim, t_depth);
+    }
+}
 
 int main(int argc, char** argv){
-    if(argc<2){ std::cerr<<"Usage: "<<argv[0]<<" file.aag\n"; return 1; }
+    unsigned threads = 1;
+    bool levelized = false;
+    unsigned partitions = 0;
+    unsigned portfolio = 0;
+    std::vector<std::string> scripts;
+    std::string objective = "area";
+    bool bench_order = false;
+    bool stats_only = false;
+    bool stats_stream = false;
+    bool trusted = false;
+    bool parallel_parse = false;
+    std::string snapshot_out;
+    const char* file = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--levelized") levelized = true;
+        else if (arg == "--partitions" && i + 1 < argc) partitions = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--portfolio" && i + 1 < argc) portfolio = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--script" && i + 1 < argc) scripts.push_back(argv[++i]);
+        else if (arg == "--objective" && i + 1 < argc) objective = argv[++i];
+        else if (arg == "--bench-order") bench_order = true;
+        else if (arg == "--stats") stats_only = true;
+        else if (arg == "--stats-stream") stats_stream = true;
+        else if (arg == "--trusted") trusted = true;
+        else if (arg == "--parallel-parse") parallel_parse = true;
+        else if (arg == "--save-snapshot" && i + 1 < argc) snapshot_out = argv[++i];
+        else if (arg[0] == '-') { usage(argv[0]); return 1; }
+        else file = argv[i];
+    }
+    if(!file){ usage(argv[0]); return 1; }
+    unsigned parse_threads = parallel_parse ? std::max(threads, 1u) : 0;
+
+    // 只看统计、不建图：边读边算
+    if (stats_stream) {
+        AigStats s;
+        if (!stream_aiger_stats(file, s)) return 1;
+        print_stats(s);
+        return 0;
+    }
+
+    // 只看统计：不需要 strash / 扇出 / 引用计数，用精简实例。
+    // 不 strash，所以数的是文件里写的门：有重复门时 area 比默认模式
+    // 第一行 (读入时已经 strash) 大，例如 01-adder 是 4 和 3
+    if (stats_only) {
+        AigPlainGraph plain;
+        if (!loadGraph(file, plain, trusted, parse_threads) || !saveGraph(plain, snapshot_out)) return 1;
+        plain.print_stats();
+        return 0;
+    }
+
+    // 没有给 --script 时，从内置脚本里取前 N 个
+    if (scripts.empty() && portfolio > 0) {
+        const auto& builtin = AigGraph::defaultScripts();
+        scripts.assign(builtin.begin(), builtin.begin() + std::min<size_t>(portfolio, builtin.size()));
+    }
+    AigObjective obj;
+    try {
+        obj = AigObjective::parse(objective);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
 
     AigGraph aig;
-    if(!read_aiger_file(argv[1],aig)) return 1;
+    if(!loadGraph(file, aig, trusted, parse_threads) || !saveGraph(aig, snapshot_out)) return 1;
+    aig.setThreads(threads);
+    aig.setLevelizedOptimize(levelized);
 
     // 优化前
     aig.print_stats();
 
     std::cout << "\noptimize\n\n";
-    aig.rewrite();
+    if (!scripts.empty()) {
+        try {
+            size_t best = aig.optimizePortfolio(scripts, obj);
+            std::cout << "best script: " << scripts[best] << "\n";
+        } catch (const std::invalid_argument& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+    else if (partitions > 1) aig.rewritePartitioned(partitions);
+    else aig.rewrite();
 
     // 优化后
     aig.print_stats();
+    if (bench_order) benchOrders(aig);
 
     return 0;
 }
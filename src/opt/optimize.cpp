@@ -0,0 +1,185 @@
+#include "aig.h"
+#include "thread_pool.h"
+#include "concurrent_strash.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// =============================================================
+// 分层并行的全局优化（去重 + 常量传播）
+// =============================================================
+// 与 optimize() 的递归 DFS 结果在结构上相同 (同样的常量传播和 strash 合并)，
+// 只是节点编号不同：新节点按 "层级 -> 层内序号" 排列。
+//
+// 活节点按层级分组后逐层处理，同一层的节点互不依赖：
+//   A. 并行算出化简后的 fanin 对，在并发 strash 里认领键 (序号小者胜)
+//   B. 并行统计每块的胜出者个数，串行前缀和得到新 ID 的起点
+//   C. 并行为胜出者建节点，写入最终字面量
+//   D. 并行让其余节点读取最终字面量
+// 胜出者和新 ID 都只由序号决定，所以节点顺序与线程数、调度无关。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::optimizeLevelized()
+{
+    if (txn_active) throw std::logic_error("optimizeLevelized: not allowed inside a transaction");
+    ThreadPool& pool = ThreadPool::global();
+    ScratchArena& arena = pool.arena();
+    ScratchArena::Scope scratch(arena);     // 可能嵌套在同一线程的外层调用里，不能 reset
+    constexpr size_t kGrain = 2048;
+    const size_t N = nodes.size();
+    const NodeStore& old_nodes = nodes;     // 并行段只读，走 const 访问，不触发写时复制
+
+    // 1. 从 Outputs 做非递归后序 DFS：遍历 ID 标记活节点，travData 暂存层级
+    incTravId();
+    setTravIdCurrent(0);
+    travData(0) = 0;
+    for (AigId id : inputs) {
+        setTravIdCurrent(id);
+        travData(id) = 0;
+    }
+
+    AigId* post = arena.alloc<AigId>(N);
+    size_t npost = 0;
+    AigLit max_level = 0;
+    for (AigLit out : outputs) {
+        trav_stack.assign(1, {lit_id(out), false});
+        while (!trav_stack.empty()) {
+            auto [id, expanded] = trav_stack.back();
+            trav_stack.pop_back();
+            const AigNode& n = nodes[id];
+            if (expanded) {
+                AigLit level = std::max(travData(lit_id(n.fanin0)), travData(lit_id(n.fanin1))) + 1;
+                travData(id) = level;
+                max_level = std::max(max_level, level);
+                post[npost++] = id;
+                continue;
+            }
+            if (isTravIdCurrent(id)) continue;
+            setTravIdCurrent(id);
+            trav_stack.push_back({id, true});
+            for (AigLit f : {n.fanin0, n.fanin1})
+                if (!isTravIdCurrent(lit_id(f))) trav_stack.push_back({lit_id(f), false});
+        }
+    }
+
+    // 2. 按层级计数排序 (层内保持后序)，level_start[L] 是第 L 层的起点
+    std::vector<size_t> level_start(max_level + 2, 0);
+    for (size_t k = 0; k < npost; ++k) level_start[travData(post[k]) + 1]++;
+    for (AigLit L = 0; L <= max_level; ++L) level_start[L + 1] += level_start[L];
+    AigId* order = arena.alloc<AigId>(npost);
+    {
+        std::vector<size_t> pos(level_start.begin(), level_start.end() - 1);
+        for (size_t k = 0; k < npost; ++k) order[pos[travData(post[k])]++] = post[k];
+    }
+
+    // 3. 常量 0 和 Inputs 保持在最前面，travData 从此改存新字面量
+    NodeStore new_nodes;
+    new_nodes.resize(1 + inputs.size() + npost);
+    new_nodes[0] = nodes[0];
+    std::vector<AigId> new_input_ids;
+    for (AigId old_in_id : inputs) {
+        AigId new_id = new_input_ids.size() + 1;
+        new_nodes[new_id].is_input = true;
+        travData(old_in_id) = make_lit(new_id, false);
+        new_input_ids.push_back(new_id);
+    }
+    AigId next_id = new_input_ids.size() + 1;
+
+    // 每个序号 k 的 strash 键 (空键表示已化简成现成字面量) 和所在槽
+    AigKey* keys = arena.alloc<AigKey>(npost);
+    size_t* slots = arena.alloc<size_t>(npost);
+    ConcurrentStrash table(npost);
+
+    std::vector<AigId> chunk_base;
+    for (AigLit L = 1; L <= max_level; ++L) {
+        const size_t lb = level_start[L], le = level_start[L + 1];
+        if (lb == le) continue;
+
+        // A. 化简 + 认领
+        pool.parallel_for(lb, le, kGrain, num_threads, [&](size_t lo, size_t hi) {
+            for (size_t k = lo; k < hi; ++k) {
+                const AigNode& n = old_nodes[order[k]];
+                AigLit l0 = travData(lit_id(n.fanin0)) ^ lit_inv(n.fanin0);
+                AigLit l1 = travData(lit_id(n.fanin1)) ^ lit_inv(n.fanin1);
+
+                AigLit res = kAigNone;
+                if (l0 == 0 || l1 == 0) { res = 0; }
+                else if (l0 == 1) { res = l1; }
+                else if (l1 == 1) { res = l0; }
+                else if (l0 == l1) { res = l0; }
+                else if (l0 == (l1 ^ 1)) { res = 0; }
+
+                if (res != kAigNone) {
+                    keys[k] = AigKey{};
+                    travData(order[k]) = res;
+                    continue;
+                }
+                if (l0 > l1) std::swap(l0, l1);
+                keys[k] = ConcurrentStrash::makeKey(l0, l1);
+                slots[k] = table.slot(keys[k]);
+                table.fetchMin(slots[k], ConcurrentStrash::kClaimTag | k);
+            }
+        });
+
+        // B. 每块的胜出者个数 -> 前缀和
+        const size_t nchunks = (le - lb + kGrain - 1) / kGrain;
+        chunk_base.assign(nchunks + 1, 0);
+        auto is_winner = [&](size_t k) {
+            return keys[k] != AigKey{} && table.value(slots[k]) == (ConcurrentStrash::kClaimTag | k);
+        };
+        pool.parallel_for(0, nchunks, 1, num_threads, [&](size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) {
+                AigId cnt = 0;
+                for (size_t k = lb + c * kGrain; k < std::min(le, lb + (c + 1) * kGrain); ++k)
+                    cnt += is_winner(k);
+                chunk_base[c + 1] = cnt;
+            }
+        });
+        chunk_base[0] = next_id;
+        for (size_t c = 0; c < nchunks; ++c) chunk_base[c + 1] += chunk_base[c];
+
+        // C. 胜出者按序号分配新 ID、建节点、写入最终字面量
+        pool.parallel_for(0, nchunks, 1, num_threads, [&](size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) {
+                AigId id = chunk_base[c];
+                for (size_t k = lb + c * kGrain; k < std::min(le, lb + (c + 1) * kGrain); ++k) {
+                    if (!is_winner(k)) continue;
+                    // 只写 fanin (resize 时 is_input 已是 false)
+                    auto&& nn = new_nodes[id];
+                    nn.fanin0 = key_lit0(keys[k]);
+                    nn.fanin1 = key_lit1(keys[k]);
+                    table.fetchMin(slots[k], make_lit(id, false));
+                    ++id;
+                }
+            }
+        });
+        next_id = chunk_base[nchunks];
+
+        // D. 所有节点记录自己的新字面量
+        pool.parallel_for(lb, le, kGrain, num_threads, [&](size_t lo, size_t hi) {
+            for (size_t k = lo; k < hi; ++k)
+                if (keys[k] != AigKey{}) travData(order[k]) = static_cast<AigLit>(table.value(slots[k]));
+        });
+    }
+
+    // 4. 更新图
+    std::vector<AigLit> new_outputs;
+    for (AigLit old_out_lit : outputs)
+        new_outputs.push_back(travData(lit_id(old_out_lit)) ^ lit_inv(old_out_lit));
+
+    new_nodes.resize(next_id);
+    nodes.swap(new_nodes);
+    inputs = new_input_ids;
+    outputs = new_outputs;
+    invalidateFanouts();
+
+    StrashTable::Map strash;
+    for (AigId id = 1; id < nodes.size(); ++id) {
+        if (nodes[id].is_input) continue;
+        strash[strash_key(nodes[id].fanin0, nodes[id].fanin1)] = make_lit(id, false);
+    }
+    computed_table.assign(std::move(strash));
+    strash_stale = false;
+}
+
+template void AigGraph::optimizeLevelized();
@@ -0,0 +1,183 @@
+#include "aig.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// =============================================================
+// 按输出锥划分的并行重写
+// =============================================================
+// 1. 按输出顺序做一遍后序 DFS，每个 AND 归第一个访问到它的输出，
+//    再把输出按顺序切成 parts 组，使各组拥有的 AND 数接近
+// 2. 每组只抽出自己拥有的 AND 成为子 AIG：用到的更早组的节点当作子图的输入，
+//    被更晚组用到的节点当作子图的额外输出 (边界)，逻辑不重复
+// 3. 各子 AIG 在线程池里各自 rewrite()，互不干扰
+// 4. 按组的顺序把子图拼进一张新图 (更早组的边界输出先有了新字面量)，
+//    optimize() 之后面积不大于输入才采用，否则改做整图 rewrite()
+// 相邻输出通常共享大量逻辑 (比如同一个加法器的各位)，所以按顺序切分。
+// -------------------------------------------------------------
+namespace {
+
+struct Partition {
+    size_t first = 0, last = 0;     // 负责 outputs[first, last)
+    AigGraph sub;
+    std::vector<AigId> input_ids;   // 子图第 k 个输入对应的原图节点 (输入或更早组的边界)
+    std::vector<AigId> export_ids;  // 子图 PO [last - first, ...) 对应的原图边界节点
+};
+// 从 roots 出发的非递归后序 DFS，visit(id) 返回 false 表示已访问过，
+// expand(id) 返回 false 时不再往 AND 的 fanin 走 (当作叶子)
+template <class Visit, class Post, class Expand>
+void postorder(const AigGraph& g, const std::vector<AigLit>& roots, Visit&& visit, Post&& post, Expand&& expand)
+{
+    std::vector<std::pair<AigId, bool>> stack;
+    for (AigLit lit : roots) {
+        stack.emplace_back(lit_id(lit), false);
+        while (!stack.empty()) {
+            auto [id, expanded] = stack.back();
+            stack.pop_back();
+            if (expanded) { post(id); continue; }
+            if (!visit(id)) continue;
+            const AigNode& n = g.nodes[id];
+            stack.emplace_back(id, true);
+            if (id == 0 || n.is_input || !expand(id)) continue;
+            stack.emplace_back(lit_id(n.fanin1), false);
+            stack.emplace_back(lit_id(n.fanin0), false);
+        }
+    }
+}
+
+} // namespace
+
+template <class F>
+void AigGraphT<F>::rewritePartitioned(unsigned parts)
+{
+    if (parts <= 1 || outputs.size() < 2) {
+        rewrite();
+        return;
+    }
+    if (parts > outputs.size()) parts = static_cast<unsigned>(outputs.size());
+    const size_t input_area = countAnds();
+    const NodeStore& src = nodes;       // 下面只读原图，不触发写时复制
+
+    // 1. 每个 AND 归第一个访问到它的输出 (first_out)；cost 就是各输出拥有的
+    //    AND 数，也就是之后抽进子图的节点数
+    constexpr uint32_t kNoOwner = ~uint32_t(0);
+    std::vector<uint32_t> owner(src.size(), kNoOwner);
+    std::vector<size_t> cost(outputs.size(), 0);
+    size_t total = 0;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        postorder(*this, {outputs[i]},
+            [&](AigId id) {
+                if (id == 0 || src[id].is_input || owner[id] != kNoOwner) return false;
+                owner[id] = static_cast<uint32_t>(i);
+                return true;
+            },
+            [&](AigId) { ++cost[i]; },
+            [](AigId) { return true; });
+        total += cost[i];
+    }
+
+    std::vector<Partition> part;
+    std::vector<uint32_t> part_of(outputs.size());
+    size_t acc = 0;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        if (part.empty() || (part.size() < parts && acc * parts >= total * part.size())) {
+            part.emplace_back();
+            part.back().first = i;
+        }
+        part.back().last = i + 1;
+        part_of[i] = static_cast<uint32_t>(part.size() - 1);
+        acc += cost[i];
+    }
+    for (uint32_t& o : owner)
+        if (o != kNoOwner) o = part_of[o];
+
+    // 被别的组 (的 AND 或 PO) 用到的 AND 是边界：拥有它的组把它作为额外输出
+    std::vector<char> exported(src.size(), 0);
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const AigId c = lit_id(outputs[i]);
+        if (owner[c] != kNoOwner && owner[c] != part_of[i]) exported[c] = 1;
+    }
+    for (AigId id = 1; id < src.size(); ++id) {
+        if (owner[id] == kNoOwner) continue;
+        const AigNode& n = src[id];
+        for (AigLit f : {n.fanin0, n.fanin1}) {
+            const AigId c = lit_id(f);
+            if (owner[c] != kNoOwner && owner[c] != owner[id]) exported[c] = 1;
+        }
+    }
+
+    // 2 + 3. 抽取子图并重写 (只读原图，各任务用自己的映射表)
+    ThreadPool::global().parallel_for(0, part.size(), 1, num_threads, [&](size_t lo, size_t hi) {
+        std::vector<AigLit> to_sub(src.size(), kAigNone);
+        for (size_t p = lo; p < hi; ++p) {
+            Partition& P = part[p];
+            std::vector<AigLit> roots(outputs.begin() + P.first, outputs.begin() + P.last);
+            std::vector<AigId> touched;
+            auto map = [&](AigLit lit) { return to_sub[lit_id(lit)] ^ (lit & 1u); };
+
+            // 不属于本组的节点 (输入、更早组的 AND) 到此为止，当作子图的输入
+            postorder(*this, roots,
+                [&](AigId id) { return to_sub[id] == kAigNone; },
+                [&](AigId id) {
+                    touched.push_back(id);
+                    if (id == 0) {
+                        to_sub[id] = 0;
+                    } else if (owner[id] != p) {
+                        to_sub[id] = make_lit(P.sub.addInput(), false);
+                        P.input_ids.push_back(id);
+                    } else {
+                        const AigNode& n = src[id];
+                        to_sub[id] = P.sub.addAnd(map(n.fanin0), map(n.fanin1));
+                        if (exported[id]) P.export_ids.push_back(id);
+                    }
+                },
+                [&](AigId id) { return id != 0 && owner[id] == p; });
+            for (AigLit lit : roots) P.sub.addOutput(map(lit));
+            for (AigId id : P.export_ids) P.sub.addOutput(map(make_lit(id, false)));
+            for (AigId id : touched) to_sub[id] = kAigNone;
+
+            P.sub.rewrite();
+        }
+    });
+
+    // 4. 按组的顺序拼进新图：rewrite() 以 optimize() 收尾，子图的 ID 已经是拓扑序。
+    //    to_out 记原图输入和边界节点在新图里的字面量，后面的组从这里取输入
+    AigGraphT out;
+    std::vector<AigLit> to_out(src.size(), kAigNone);
+    to_out[0] = 0;
+    for (AigId id : inputs) to_out[id] = make_lit(out.addInput(), false);
+    std::vector<AigLit> new_outputs(outputs.size());
+    for (const Partition& P : part) {
+        const AigGraph& sub = P.sub;
+        std::vector<AigLit> to_main(sub.nodes.size(), kAigNone);
+        to_main[0] = 0;
+        for (size_t k = 0; k < sub.inputs.size(); ++k) to_main[sub.inputs[k]] = to_out[P.input_ids[k]];
+        auto map = [&](AigLit lit) { return to_main[lit_id(lit)] ^ (lit & 1u); };
+
+        for (AigId id = 1; id < sub.nodes.size(); ++id) {
+            const AigNode& n = sub.nodes[id];
+            if (n.is_input) continue;
+            to_main[id] = out.addAnd(map(n.fanin0), map(n.fanin1));
+        }
+        const size_t nout = P.last - P.first;
+        for (size_t i = 0; i < nout; ++i) new_outputs[P.first + i] = map(sub.outputs[i]);
+        for (size_t k = 0; k < P.export_ids.size(); ++k) to_out[P.export_ids[k]] = map(sub.outputs[nout + k]);
+    }
+    for (AigLit lit : new_outputs) out.addOutput(lit);
+    out.optimize();     // 去掉后面的组已经不再用到的边界节点
+
+    // 边界挡住了跨组的改写，拼回的结果不一定更好：比输入大就改做整图 rewrite()
+    if (out.countAnds() > input_area) {
+        rewrite();
+        return;
+    }
+    const unsigned threads = num_threads;
+    const bool levelized = levelized_opt;
+    *this = std::move(out);
+    num_threads = threads;
+    levelized_opt = levelized;
+    assignPhases();
+}
+
+template void AigGraph::rewritePartitioned(unsigned);
@@ -0,0 +1,44 @@
+#include "aig.h"
+#include <cstdint>
+
+// =============================================================
+// 相位分配 (Phase assignment)
+// =============================================================
+// AND 节点既可以按原样实现，也可以实现成 NAND 再由扇出端吸收反相。
+// 一个节点需要反相器，当且仅当存在某个引用 (AND 的 fanin 或 PO)
+// 的极性与它的实现极性不同。把所有引用的极性推到节点上：
+//   - 只被反相引用的节点改为反相实现，反相器消失
+//   - 正反两种引用都有的节点，无论如何都需要 1 个反相器，保持正相
+// 输入和常量没有选择的余地，保持正相。
+// 逻辑功能和面积都不变，一次线性扫描完成。
+// -------------------------------------------------------------
+template <class F>
+void AigGraphT<F>::assignPhases()
+{
+    // travData 的两位：bit0 = 有正相引用，bit1 = 有反相引用
+    incTravId();
+    auto use = [&](AigLit lit) {
+        AigId id = lit_id(lit);
+        if (!isTravIdCurrent(id)) {
+            setTravIdCurrent(id);
+            travData(id) = 0;
+        }
+        travData(id) |= lit_inv(lit) ? 2u : 1u;
+    };
+
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        const AigNode& n = nodes[i];
+        if (n.is_input) continue;
+        use(n.fanin0);
+        use(n.fanin1);
+    }
+    for (AigLit lit : outputs) use(lit);
+
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        auto&& n = nodes[i];
+        if (n.is_input) continue;
+        n.phase = isTravIdCurrent(static_cast<AigId>(i)) && travData(static_cast<AigId>(i)) == 2u;
+    }
+}
+
+template void AigGraph::assignPhases();
@@ -0,0 +1,409 @@
+#include "aig.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// =============================================================
+// Refactor：把大割集上的锥折叠成 ISOP，再代数因式分解后重建
+// =============================================================
+// 与 rewriteCommonFactor_P1 只看两层结构不同，这里对每个节点取一个
+// 最多 kRefactorLeaves 个叶子的重汇聚割集 (reconvCut)，计算整个锥的真值表，
+// 因此能发现跨越多层的冗余。
+// -------------------------------------------------------------
+
+namespace {
+
+constexpr int kRefactorLeaves = 10;                          // 割集叶子上限
+constexpr int kRefactorConeMax = 64;                         // 锥内部节点上限
+constexpr int kRefactorCubesMax = 64;                        // ISOP 立方体上限
+constexpr int kTruthWords = 1 << (kRefactorLeaves - 6);      // 10 变量 = 16 个 64 位字
+
+// -------------------------
+// 真值表 (最多 10 个变量)
+// -------------------------
+struct Truth {
+    uint64_t w[kTruthWords];
+};
+
+const uint64_t kVarMask[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+inline int truth_words(int nvars) {
+    return nvars <= 6 ? 1 : 1 << (nvars - 6);
+}
+
+inline Truth truth_const(int nw, bool one) {
+    Truth t;
+    for (int i = 0; i < nw; ++i) t.w[i] = one ? ~0ULL : 0ULL;
+    return t;
+}
+
+inline Truth truth_var(int v, int nw) {
+    Truth t;
+    for (int i = 0; i < nw; ++i) {
+        if (v < 6) t.w[i] = kVarMask[v];
+        else       t.w[i] = ((i >> (v - 6)) & 1) ? ~0ULL : 0ULL;
+    }
+    return t;
+}
+
+inline bool truth_is_const(const Truth& t, int nw, bool one) {
+    const uint64_t c = one ? ~0ULL : 0ULL;
+    for (int i = 0; i < nw; ++i)
+        if (t.w[i] != c) return false;
+    return true;
+}
+
+inline bool truth_equal(const Truth& a, const Truth& b, int nw) {
+    for (int i = 0; i < nw; ++i)
+        if (a.w[i] != b.w[i]) return false;
+    return true;
+}
+
+// 把 t 的变量 v 固定为 phase，结果仍然在完整空间上展开
+inline Truth truth_cofactor(const Truth& t, int v, bool phase, int nw) {
+    Truth r;
+    if (v < 6) {
+        const int s = 1 << v;
+        for (int i = 0; i < nw; ++i) {
+            if (phase) {
+                uint64_t x = t.w[i] & kVarMask[v];
+                r.w[i] = x | (x >> s);
+            } else {
+                uint64_t x = t.w[i] & ~kVarMask[v];
+                r.w[i] = x | (x << s);
+            }
+        }
+    } else {
+        const int step = 1 << (v - 6);
+        for (int i = 0; i < nw; i += 2 * step) {
+            for (int j = 0; j < step; ++j) {
+                uint64_t x = phase ? t.w[i + j + step] : t.w[i + j];
+                r.w[i + j] = x;
+                r.w[i + j + step] = x;
+            }
+        }
+    }
+    return r;
+}
+
+inline bool truth_has_var(const Truth& t, int v, int nw) {
+    return !truth_equal(truth_cofactor(t, v, false, nw), truth_cofactor(t, v, true, nw), nw);
+}
+
+// 立方体编码：第 2v 位 = 正变量 v，第 2v+1 位 = 反变量 v
+inline uint32_t cube_lit(int v, bool neg) {
+    return 1u << (2 * v + (neg ? 1 : 0));
+}
+
+// -------------------------
+// Minato-Morreale ISOP
+// -------------------------
+// 求 L <= R <= U 的不冗余积之和，立方体追加到 cover。
+// 返回 R；立方体数超过上限时把 ok 置 false。
+Truth isop(const Truth& L, const Truth& U, int nvars, int nw,
+           std::vector<uint32_t>& cover, bool& ok)
+{
+    if (!ok || truth_is_const(L, nw, false)) return truth_const(nw, false);
+    if (truth_is_const(U, nw, true)) {
+        cover.push_back(0);
+        if (cover.size() > static_cast<size_t>(kRefactorCubesMax)) ok = false;
+        return truth_const(nw, true);
+    }
+
+    int v = nvars - 1;
+    while (v >= 0 && !truth_has_var(L, v, nw) && !truth_has_var(U, v, nw)) --v;
+    assert(v >= 0);
+
+    Truth L0 = truth_cofactor(L, v, false, nw), L1 = truth_cofactor(L, v, true, nw);
+    Truth U0 = truth_cofactor(U, v, false, nw), U1 = truth_cofactor(U, v, true, nw);
+    Truth tmp;
+
+    size_t b0 = cover.size();
+    for (int i = 0; i < nw; ++i) tmp.w[i] = L0.w[i] & ~U1.w[i];
+    Truth R0 = isop(tmp, U0, v, nw, cover, ok);
+    size_t b1 = cover.size();
+    for (int i = 0; i < nw; ++i) tmp.w[i] = L1.w[i] & ~U0.w[i];
+    Truth R1 = isop(tmp, U1, v, nw, cover, ok);
+    size_t b2 = cover.size();
+
+    Truth Ln, Un;
+    for (int i = 0; i < nw; ++i) {
+        Ln.w[i] = (L0.w[i] & ~R0.w[i]) | (L1.w[i] & ~R1.w[i]);
+        Un.w[i] = U0.w[i] & U1.w[i];
+    }
+    Truth R2 = isop(Ln, Un, v, nw, cover, ok);
+    if (!ok) return R2;
+
+    for (size_t i = b0; i < b1; ++i) cover[i] |= cube_lit(v, true);
+    for (size_t i = b1; i < b2; ++i) cover[i] |= cube_lit(v, false);
+
+    Truth xv = truth_var(v, nw), R;
+    for (int i = 0; i < nw; ++i)
+        R.w[i] = (R0.w[i] & ~xv.w[i]) | (R1.w[i] & xv.w[i]) | R2.w[i];
+    return R;
+}
+
+int cover_literals(const std::vector<uint32_t>& cover) {
+    int n = 0;
+    for (uint32_t c : cover) n += __builtin_popcount(c);
+    return n;
+}
+
+// -------------------------
+// 因式分解后的重建
+// -------------------------
+// dry 模式只查表不建点，用于估算代价；不存在的节点用
+// >= nodes.size() 的虚拟 ID 表示，查表时自然查不到。
+struct Res {
+    AigLit lit;
+    uint32_t level;
+};
+
+class ConeBuilder {
+public:
+    ConeBuilder(AigGraph& g, bool dry, const std::vector<AigLit>& leaf_lits,
+                std::vector<uint32_t>& levels, AigId root)
+        : g(g), dry(dry), leaf_lits(leaf_lits), levels(levels), root(root),
+          base(g.nodes.size()), next_virtual(g.nodes.size()) {}
+
+    int added = 0;      // dry 模式下需要新建的节点数
+    bool loop = false;  // real 模式下 strash 命中了根节点自身 (会成环)
+
+    Res leaf(int v, bool neg) const {
+        AigLit lit = leaf_lits[v] ^ static_cast<AigLit>(neg);
+        return Res{lit, levels[lit_id(lit)]};
+    }
+
+    static Res inv(Res a) { return Res{a.lit ^ 1u, a.level}; }
+
+    Res and2(Res a, Res b) {
+        if (a.lit == 0 || b.lit == 0) return Res{0, 0};
+        if (a.lit == 1) return b;
+        if (b.lit == 1) return a;
+        if (a.lit == b.lit) return a;
+        if (a.lit == (b.lit ^ 1)) return Res{0, 0};
+
+        uint32_t level = std::max(a.level, b.level) + 1;
+        if (dry) {
+            AigLit lit = g.lookupAnd(a.lit, b.lit);
+            // MFFC 内的节点 (当前遍历 ID 标记) 重建后仍会被删掉，按新建计费
+            if (lit != kAigNone && !g.isTravIdCurrent(lit_id(lit)))
+                return Res{lit, levels[lit_id(lit)]};
+            ++added;
+            return Res{make_lit(next_virtual++), level};
+        }
+
+        AigLit lit = g.addAnd(a.lit, b.lit);
+        AigId id = lit_id(lit);
+        if (id == root) loop = true;
+        if (id >= levels.size()) levels.resize(id + 1, 0);
+        if (id >= base) levels[id] = level;
+        return Res{lit, levels[id]};
+    }
+
+    // 多输入 AND：每次合并层级最低的两个，尽量压低深度
+    // (只按层级稳定排序，保证 dry 与 real 两次的合并顺序一致)
+    Res andN(std::vector<Res> xs) {
+        if (xs.empty()) return Res{1, 0};
+        auto by_level = [](const Res& a, const Res& b) { return a.level < b.level; };
+        std::stable_sort(xs.begin(), xs.end(), by_level);
+        while (xs.size() > 1) {
+            Res r = and2(xs[0], xs[1]);
+            xs.erase(xs.begin(), xs.begin() + 2);
+            xs.insert(std::upper_bound(xs.begin(), xs.end(), r, by_level), r);
+        }
+        return xs[0];
+    }
+
+    Res orN(std::vector<Res> xs) {
+        for (Res& x : xs) x = inv(x);
+        return inv(andN(std::move(xs)));
+    }
+
+    Res cube(uint32_t c, int nvars) {
+        std::vector<Res> xs;
+        for (int v = 0; v < nvars; ++v) {
+            if (c & cube_lit(v, false)) xs.push_back(leaf(v, false));
+            if (c & cube_lit(v, true))  xs.push_back(leaf(v, true));
+        }
+        return andN(std::move(xs));
+    }
+
+    // 代数因式分解：反复提取出现次数最多的文字
+    // F = l * (F / l) + R
+    Res factor(const std::vector<uint32_t>& cover, int nvars) {
+        if (cover.empty()) return Res{0, 0};
+        if (cover.size() == 1) return cube(cover[0], nvars);
+
+        int best = -1, best_cnt = 1;
+        for (int b = 0; b < 2 * nvars; ++b) {
+            int cnt = 0;
+            for (uint32_t c : cover) cnt += (c >> b) & 1;
+            if (cnt > best_cnt) { best = b; best_cnt = cnt; }
+        }
+
+        if (best < 0) {
+            std::vector<Res> xs;
+            for (uint32_t c : cover) xs.push_back(cube(c, nvars));
+            return orN(std::move(xs));
+        }
+
+        std::vector<uint32_t> quo, rem;
+        for (uint32_t c : cover) {
+            if ((c >> best) & 1) quo.push_back(c & ~(1u << best));
+            else rem.push_back(c);
+        }
+        Res q = factor(quo, nvars);
+        Res t = and2(leaf(best >> 1, best & 1), q);
+        if (rem.empty()) return t;
+        return orN({t, factor(rem, nvars)});
+    }
+
+private:
+    AigGraph& g;
+    bool dry;
+    const std::vector<AigLit>& leaf_lits;
+    std::vector<uint32_t>& levels;
+    AigId root;
+    AigId base;             // 建造前的节点数，>= base 的是新节点
+    AigId next_virtual;
+};
+
+// 引用计数的递归增减 (refs 只统计活节点的引用)
+// deref 返回随之死掉的 AND 节点数，collect 非空时顺便收集这些节点
+constexpr AigId kPinned = 1 << 20;   // 叶子临时加上的引用，保证 deref 不越过割集
+
+template <class Refs>
+int deref_rec(const AigGraph& g, AigId id, Refs& refs,
+              std::vector<AigId>* collect = nullptr) {
+    const AigNode& n = g.nodes[id];
+    if (id == 0 || n.is_input) return 0;
+    if (collect) collect->push_back(id);
+    int cnt = 1;
+    for (AigLit f : {n.fanin0, n.fanin1}) {
+        AigId fid = lit_id(f);
+        if (fid != 0 && --refs[fid] == 0) cnt += deref_rec(g, fid, refs, collect);
+    }
+    return cnt;
+}
+
+template <class Refs>
+void ref_rec(const AigGraph& g, AigId id, Refs& refs) {
+    const AigNode& n = g.nodes[id];
+    if (id == 0 || n.is_input) return;
+    for (AigLit f : {n.fanin0, n.fanin1}) {
+        AigId fid = lit_id(f);
+        if (fid != 0 && refs[fid]++ == 0) ref_rec(g, fid, refs);
+    }
+}
+
+} // namespace
+
+template <class F>
+void AigGraphT<F>::refactor()
+{
+    // 引用计数用 replace() 维护的那份；MFFC 估算时临时减掉再加回
+    if (!refs_tracked) buildRefCounts();
+    std::vector<AigId>& refs = ref_count;
+    const AigId N = nodes.size();
+
+    // 层级按后序 DFS 计算，不依赖 ID 是拓扑序 (addAnd 复用过死节点槽位时不是)
+    std::vector<uint32_t> levels(N, 0);
+    std::vector<AigId> post;
+    topoOrder(post);
+    for (AigId id : post) levels[id] = static_cast<uint32_t>(travData(id));
+
+    // 整个 pass 共用的缓冲区；逐节点的标记全部用遍历 ID
+    std::vector<AigId> leaves, cone, mffc;
+    std::vector<AigLit> leaf_lits;
+    std::vector<Truth> tts;
+    std::vector<uint32_t> cover, cover_neg;
+
+    for (AigId root = 1; root < N; ++root) {
+        // 前面的 replace() 删掉的节点、刚建好还没接上的节点都跳过
+        if (nodes[root].is_input || isDeadNode(nodes[root]) || refs[root] == 0) continue;
+
+        // 1. 重汇聚驱动的割集
+        reconvCut(root, kRefactorLeaves, kRefactorConeMax, leaves, cone);
+
+        // 2. 锥内节点按拓扑序仿真出真值表 (travData 存真值表下标)
+        const int nvars = static_cast<int>(leaves.size());
+        const int nw = truth_words(nvars);
+        tts.clear();
+        leaf_lits.clear();
+        incTravId();
+        auto set_slot = [&](AigId id) {
+            setTravIdCurrent(id);
+            travData(id) = tts.size();
+        };
+        for (int v = 0; v < nvars; ++v) {
+            set_slot(leaves[v]);
+            tts.push_back(truth_var(v, nw));
+            leaf_lits.push_back(make_lit(leaves[v]));
+        }
+        set_slot(0);
+        tts.push_back(truth_const(nw, false));
+
+        for (AigId id : cone) {
+            const AigNode& n = nodes[id];
+            const Truth& t0 = tts[travData(lit_id(n.fanin0))];
+            const Truth& t1 = tts[travData(lit_id(n.fanin1))];
+            const uint64_t m0 = lit_inv(n.fanin0) ? ~0ULL : 0ULL;
+            const uint64_t m1 = lit_inv(n.fanin1) ? ~0ULL : 0ULL;
+            Truth t;
+            for (int i = 0; i < nw; ++i) t.w[i] = (t0.w[i] ^ m0) & (t1.w[i] ^ m1);
+            set_slot(id);
+            tts.push_back(t);
+        }
+        Truth func = tts[travData(root)];
+
+        // 3. MFFC：根节点被替换后会一起死掉的部分 (以割集叶子为界)
+        for (AigId id : leaves) refs[id] += kPinned;
+        mffc.clear();
+        int mffc_size = deref_rec(*this, root, refs, &mffc);
+        ref_rec(*this, root, refs);
+        for (AigId id : leaves) refs[id] -= kPinned;
+        incTravId();
+        for (AigId id : mffc) setTravIdCurrent(id);
+
+        // 4. 正反两个极性的 ISOP，取文字数较少的
+        cover.clear();
+        cover_neg.clear();
+        bool ok = true, ok_neg = true;
+        Truth nfunc;
+        for (int i = 0; i < nw; ++i) nfunc.w[i] = ~func.w[i];
+        isop(func, func, nvars, nw, cover, ok);
+        isop(nfunc, nfunc, nvars, nw, cover_neg, ok_neg);
+        bool use_neg = false;
+        if (!ok && !ok_neg) continue;
+        if (!ok || (ok_neg && cover_literals(cover_neg) < cover_literals(cover))) use_neg = true;
+        const std::vector<uint32_t>& best_cover = use_neg ? cover_neg : cover;
+
+        // 5. 先 dry-run 估算，确实更小且根节点层级不升高才真正重建
+        ConeBuilder probe(*this, true, leaf_lits, levels, root);
+        Res est = probe.factor(best_cover, nvars);
+        bool accept = probe.added < mffc_size && est.level <= levels[root] && lit_id(est.lit) != root;
+        if (!accept) continue;
+
+        // 真正建出来才知道会不会绕回根节点；绕回时整笔撤销，不留下悬空节点
+        beginTransaction();
+        ConeBuilder builder(*this, false, leaf_lits, levels, root);
+        Res res = builder.factor(best_cover, nvars);
+        if (builder.loop || lit_id(res.lit) == root) {
+            rollbackTransaction();
+            if (!refs_tracked) buildRefCounts();    // 回滚没能增量恢复计数时
+            continue;
+        }
+        commitTransaction();
+
+        // 6. 提交：扇出和 PO 改指新结构，旧的 MFFC 随之删除
+        replace(root, res.lit ^ static_cast<AigLit>(use_neg));
+    }
+
+    optimize();
+}
+
+template void AigGraph::refactor();
@@ -0,0 +1,172 @@
+#include "aig.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// =============================================================
+// 优化脚本
+// =============================================================
+namespace {
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t");
+    return s.substr(b, e - b + 1);
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    for (;;) {
+        size_t p = s.find(sep, start);
+        out.push_back(trim(s.substr(start, p - start)));
+        if (p == std::string::npos) return out;
+        start = p + 1;
+    }
+}
+
+// 解析成 (步骤, 次数) 序列；先整体解析，避免执行到一半才发现后面写错
+std::vector<std::pair<std::string, unsigned>> parseScript(const std::string& script)
+{
+    std::vector<std::pair<std::string, unsigned>> steps;
+    for (const std::string& tok : split(script, ';')) {
+        if (tok.empty()) continue;
+        std::string name = tok;
+        unsigned times = 1;
+        size_t star = tok.find('*');
+        if (star != std::string::npos) {
+            name = trim(tok.substr(0, star));
+            std::string cnt = trim(tok.substr(star + 1));
+            char* end = nullptr;
+            times = std::strtoul(cnt.c_str(), &end, 10);
+            if (cnt.empty() || *end != '\0' || times == 0)
+                throw std::invalid_argument("runScript: bad repeat count in '" + tok + "'");
+        }
+        if (name != "rw" && name != "p1" && name != "p2" && name != "rf" && name != "opt")
+            throw std::invalid_argument("runScript: unknown step '" + name + "'");
+        steps.emplace_back(name, times);
+    }
+    return steps;
+}
+
+} // namespace
+
+template <class F>
+void AigGraphT<F>::runScript(const std::string& script)
+{
+    for (auto const& [name, times] : parseScript(script)) {
+        for (unsigned i = 0; i < times; ++i) {
+            if (name == "rw") {
+                rewrite_phase1();
+                optimize();
+                rewrite_phase2();
+            }
+            else if (name == "p1") rewrite_phase1();
+            else if (name == "p2") rewrite_phase2();
+            else if (name == "rf") refactor();
+            else optimize();
+        }
+    }
+    assignPhases();
+}
+
+// =============================================================
+// 组合优化 (portfolio)
+// =============================================================
+// 不同设计适合的 pass 顺序和轮数不同，与其固定一套流程，不如在空闲的
+// 核上同时试几套，取目标最优的一个。每个脚本独占一个副本，互不干扰。
+// -------------------------------------------------------------
+template <class F>
+const std::vector<std::string>& AigGraphT<F>::defaultScripts()
+{
+    static const std::vector<std::string> scripts = {
+        "rw*3",             // 与 rewrite() 相同
+        "rw*3;rf",
+        "rf;rw*3",
+        "rw*5",
+        "rw;rf;rw;rf",
+        "rw*2",
+        "rf;rw*3;rf",
+        "rw*8",
+    };
+    return scripts;
+}
+
+AigObjective AigObjective::parse(const std::string& spec)
+{
+    AigObjective o;
+    if (spec == "area") return o;
+    if (spec == "depth") { o.area = 0; o.depth = 1; return o; }
+    if (spec == "not") { o.area = 0; o.inverters = 1; return o; }
+    if (spec == "mix") { o.depth = 1; o.inverters = 1; return o; }
+    if (spec.compare(0, 4, "mix:") == 0) {
+        std::vector<std::string> w = split(spec.substr(4), ',');
+        if (w.size() == 3) {
+            double* dst[3] = {&o.area, &o.depth, &o.inverters};
+            bool ok = true;
+            for (int i = 0; i < 3; ++i) {
+                char* end = nullptr;
+                *dst[i] = std::strtod(w[i].c_str(), &end);
+                ok = ok && !w[i].empty() && *end == '\0' && *dst[i] >= 0;
+            }
+            if (ok) return o;
+        }
+    }
+    throw std::invalid_argument("unknown objective '" + spec + "'");
+}
+
+double AigObjective::score(const AigStats& s) const
+{
+    return area * s.area + depth * s.depth + inverters * s.inverters;
+}
+
+bool AigObjective::better(const AigStats& a, const AigStats& b) const
+{
+    double sa = score(a), sb = score(b);
+    if (sa != sb) return sa < sb;
+    if (a.area != b.area) return a.area < b.area;
+    if (a.depth != b.depth) return a.depth < b.depth;
+    return a.inverters < b.inverters;
+}
+
+template <class F>
+size_t AigGraphT<F>::optimizePortfolio(const std::vector<std::string>& scripts, const AigObjective& obj)
+{
+    if (scripts.empty()) throw std::invalid_argument("optimizePortfolio: no scripts");
+    for (const std::string& sc : scripts) parseScript(sc);     // 在线程外报错
+
+    // 只有一个脚本时不用比较，直接在本图上跑：副本会让原图一直拖着
+    // 所有共享块，每写一块都要复制一块
+    if (scripts.size() == 1) {
+        runScript(scripts[0]);
+        return 0;
+    }
+
+    // 每个副本内部串行，线程都用在副本之间
+    std::vector<AigGraphT> clones(scripts.size(), *this);
+    std::vector<AigStats> result(scripts.size());
+    ThreadPool::global().parallel_for(0, scripts.size(), 1, num_threads, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            clones[i].setThreads(1);
+            clones[i].runScript(scripts[i]);
+            result[i] = clones[i].stats();
+        }
+    });
+
+    // 相同目标取下标最小的，结果与调度无关
+    size_t best = 0;
+    for (size_t i = 1; i < scripts.size(); ++i)
+        if (obj.better(result[i], result[best])) best = i;
+
+    unsigned threads = num_threads;
+    *this = std::move(clones[best]);
+    num_threads = threads;
+    return best;
+}
+
+template void AigGraph::runScript(const std::string&);
+template const std::vector<std::string>& AigGraph::defaultScripts();
+template size_t AigGraph::optimizePortfolio(const std::vector<std::string>&, const AigObjective&);
@@ -2,6 +2,7 @@ import os
 import subprocess
 import re
 import sys
+import tempfile
 
 # ================= 配置区域 =================
 # 可执行文件路径 (相对于脚本所在目录)
@@ -45,6 +46,87 @@ def parse_stats(text):
         "not": int(last_match[4])
     }
 
+# 读入方式和优化脚本的一致性检查：(名称, 参数, 对照参数, 比较方式)
+#   "full"  整个输出必须与对照完全相同
+#   "final" 只比较最后一行 (优化后) 的统计；--trusted 不 strash 文件里的重复门，
+#           优化前的那一行可以不同
+#   "area"  最后一行的 pis/pos 相同，area 不大于对照
+MODE_CHECKS = [
+    ("--trusted", ["--trusted"], [], "final"),
+    ("--parallel-parse -j 1", ["--parallel-parse", "-j", "1"], [], "full"),
+    ("--parallel-parse -j 3", ["--parallel-parse", "-j", "3"], [], "full"),
+    ("--trusted --parallel-parse", ["--trusted", "--parallel-parse", "-j", "3"], [], "final"),
+    ("--stats-stream", ["--stats-stream"], ["--stats"], "full"),
+    ("--script rf", ["--script", "rf"], [], "area"),
+    ("--partitions 4", ["--partitions", "4"], [], "area"),
+    # 多线程的 pass 结果与线程数无关
+    ("-j 3", ["-j", "3"], [], "full"),
+    ("--levelized -j 3", ["--levelized", "-j", "3"], ["--levelized"], "full"),
+    ("--partitions 4 -j 3", ["--partitions", "4", "-j", "3"], ["--partitions", "4", "-j", "1"], "full"),
+]
+
+def run_binary(args, timeout=30):
+    result = subprocess.run([BINARY_PATH] + args, capture_output=True, text=True, timeout=timeout)
+    if result.returncode != 0:
+        raise RuntimeError(f"return {result.returncode}: {result.stderr.strip()}")
+    return result.stdout
+
+def same_output(a, b, how):
+    if how == "full":
+        return a == b
+    sa, sb = parse_stats(a), parse_stats(b)
+    if sa is None or sb is None:
+        return False
+    if how == "area":
+        return sa["pis"] == sb["pis"] and sa["pos"] == sb["pos"] and sa["area"] <= sb["area"]
+    return sa == sb
+
+def check_modes(aag_files):
+    """
+    各种读入方式 (可信模式、并行解析、流式统计、快照往返) 在每个网表上
+    都应当与默认方式给出相同的结果，优化脚本不应比默认流程差，
+    多线程的优化与单线程逐字相同。
+    返回失败列表 [(文件名, 原因)]。
+    """
+    failed = []
+    snapshot = os.path.join(tempfile.gettempdir(), f"aig_test_{os.getpid()}.snap")
+    for aag_path in aag_files:
+        file = os.path.basename(aag_path)
+        print(f"Modes   {Colors.BOLD}{file:<15}{Colors.ENDC} ... ", end="")
+        diffs = []
+        try:
+            cache = {}
+            def output(args):
+                key = tuple(args)
+                if key not in cache:
+                    cache[key] = run_binary(args + [aag_path])
+                return cache[key]
+
+            for name, args, ref_args, how in MODE_CHECKS:
+                if not same_output(output(args), output(ref_args), how):
+                    what = "is worse than" if how == "area" else "differs from"
+                    diffs.append(f"{name} {what} {' '.join(ref_args) or 'default'}")
+
+            # 快照往返：读入后存成快照，再用快照代替原文件，输出应当相同
+            for name, args in (("snapshot", []), ("snapshot --stats", ["--stats"])):
+                saved = run_binary(args + ["--save-snapshot", snapshot, aag_path])
+                if saved != output(args) or run_binary(args + [snapshot]) != saved:
+                    diffs.append(f"{name} round trip differs")
+        except (RuntimeError, subprocess.TimeoutExpired) as e:
+            diffs.append(f"run failed: {e}")
+        finally:
+            if os.path.exists(snapshot):
+                os.remove(snapshot)
+
+        if not diffs:
+            print(f"{Colors.OKGREEN}PASS{Colors.ENDC}")
+        else:
+            print(f"{Colors.FAIL}FAIL{Colors.ENDC}")
+            for d in diffs:
+                print(f"  └─ {d}")
+            failed.append((file, ", ".join(diffs)))
+    return failed
+
 def run_test():
     # 检查二进制文件是否存在
     if not os.path.isfile(BINARY_PATH):
@@ -57,12 +139,14 @@ def run_test():
     print(f"Test Dir: {TEST_DIR}\n")
 
     failed_cases = []
+    aag_files = []
     
     # 遍历目录
     for root, dirs, files in os.walk(TEST_DIR):
         for file in files:
             if file.endswith(".aag"):
                 aag_path = os.path.join(root, file)
+                aag_files.append(aag_path)
                 txt_path = os.path.join(root, file.replace(".aag", ".txt"))
                 
                 # 打印文件名，保持光标在同一行等待结果
@@ -158,6 +242,9 @@ def run_test():
 
                     failed_cases.append((file, ", ".join(diffs)))
 
+    print()
+    failed_cases += check_modes(sorted(aag_files))
+
     # ================= 汇总报告 =================
     print("\n" + "="*40)
     print("Test Summary")
@@ -0,0 +1,102 @@
+#pragma once
+#include "aig.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// -------------------------
+// 单元测试的公共部分
+// -------------------------
+// 每个测试程序从仓库根目录运行 (见 CMakeLists.txt)，失败时打印位置并以非 0 退出
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                               \
+        }                                                                               \
+    } while (0)
+
+// test/ 下的某个用例，例如 loadCase("case_simple/s1196")
+inline AigGraph loadCase(const std::string& name)
+{
+    AigGraph g;
+    CHECK(read_aiger_file("test/" + name + ".aag", g));
+    return g;
+}
+
+// 用例集里适合反复改写的几个 (div 太大，单元测试里不用)
+inline const std::vector<std::string>& unitCases()
+{
+    static const std::vector<std::string> cases = {
+        "case_simple/01-adder", "case_simple/02-adder", "case_simple/z4ml",
+        "case_simple/s1196",    "case_simple/s1488",    "case_complex/mem_ctrl",
+    };
+    return cases;
+}
+
+// 同一组随机输入下两张图的 PO 是否逐位相同 (输入个数、顺序一致)
+inline bool sameOutputs(const AigGraph& a, const AigGraph& b, uint64_t seed = 1, int rounds = 8)
+{
+    if (a.inputs.size() != b.inputs.size() || a.outputs.size() != b.outputs.size()) return false;
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> words(a.inputs.size()), va, vb;
+    auto out = [](const std::vector<uint64_t>& v, AigLit lit) {
+        return lit_inv(lit) ? ~v[lit_id(lit)] : v[lit_id(lit)];
+    };
+    for (int r = 0; r < rounds; ++r) {
+        for (uint64_t& w : words) w = rng();
+        a.simulate(words, va);
+        b.simulate(words, vb);
+        for (size_t i = 0; i < a.outputs.size(); ++i)
+            if (out(va, a.outputs[i]) != out(vb, b.outputs[i])) return false;
+    }
+    return true;
+}
+
+// 两张图的节点和 PO 是否逐个相同
+inline bool sameStructure(const AigGraph& a, const AigGraph& b)
+{
+    if (a.nodes.size() != b.nodes.size() || a.inputs != b.inputs || a.outputs != b.outputs) return false;
+    for (AigId id = 0; id < a.nodes.size(); ++id) {
+        const AigNode x = a.nodes[id], y = b.nodes[id];
+        if (x.is_input != y.is_input || x.fanin0 != y.fanin0 || x.fanin1 != y.fanin1) return false;
+    }
+    return true;
+}
+
+// 每个 AND 的 fanin ID 都小于自身
+inline bool isTopological(const AigGraph& g)
+{
+    for (AigId id = 1; id < g.nodes.size(); ++id) {
+        const AigNode n = g.nodes[id];
+        if (!n.is_input && (lit_id(n.fanin0) >= id || lit_id(n.fanin1) >= id)) return false;
+    }
+    return true;
+}
+
+// 在随机的活 AND 上用 replace() 做一次结合律改写
+// AND(AND(c, d), b) -> AND(c, AND(d, b))；找不到可改写的节点时返回 false
+inline bool rotateOnce(AigGraph& g, std::mt19937_64& rng)
+{
+    const size_t N = g.nodes.size();
+    for (size_t tries = 0; tries < N; ++tries) {
+        AigId id = static_cast<AigId>(1 + rng() % (N - 1));
+        const AigNode n = g.nodes[id];
+        if (n.is_input || AigGraph::isDeadNode(n)) continue;
+        AigLit a = n.fanin0, b = n.fanin1;
+        if (rng() % 2) std::swap(a, b);
+        const AigNode m = g.nodes[lit_id(a)];
+        if (lit_inv(a) || m.is_input || lit_id(a) == 0) continue;
+        AigLit c = m.fanin0, d = m.fanin1;
+        if (rng() % 2) std::swap(c, d);
+        AigLit lit = g.addAnd(c, g.addAnd(d, b));
+        if (lit_id(lit) == id) continue;
+        g.replace(id, lit);
+        return true;
+    }
+    return false;
+}
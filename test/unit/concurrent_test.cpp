@@ -0,0 +1,112 @@
+#include "check.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// =============================================================
+// 并发构造
+// =============================================================
+// 几个线程先各建第一层里互相重叠的一段，全部建完后再各自按不同顺序
+// addAndConcurrent 整组 fanin 对 (有一部分已经在 computed_table 里，第二层
+// 用到别的线程块里建的节点)：同一对在所有线程里得到同一个字面量；
+// endConcurrent 之后 ID 是拓扑序，新字面量当作 PO 时与串行 addAnd 建出的图
+// 仿真结果逐位相同。
+// -------------------------------------------------------------
+
+constexpr unsigned kThreads = 4;
+
+struct Pair {
+    AigLit a, b;    // 第一层：原图的字面量；第二层：第一层结果的下标 (低位是取反)
+};
+
+static void checkConcurrent(const std::string& name, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    const AigGraph ref = loadCase(name);
+    std::vector<AigId> live;
+    for (AigId id = 1; id < ref.nodes.size(); ++id)
+        if (!AigGraph::isDeadNode(ref.nodes[id])) live.push_back(id);
+    auto randomLit = [&] { return make_lit(live[rng() % live.size()], rng() % 2); };
+
+    // 第一层：原图已有的 AND (及其取反组合) 和随机的新组合
+    std::vector<Pair> level1, level2;
+    for (AigId id = 1; id < ref.nodes.size() && level1.size() < 64; ++id) {
+        const AigNode n = ref.nodes[id];
+        if (!n.is_input && !AigGraph::isDeadNode(n)) level1.push_back({n.fanin1, n.fanin0});
+    }
+    while (level1.size() < 512) level1.push_back({randomLit(), randomLit()});
+    for (size_t k = 0; k < 256; ++k) {
+        AigLit i = static_cast<AigLit>(rng() % level1.size()), j = static_cast<AigLit>(rng() % level1.size());
+        level2.push_back({make_lit(i, rng() % 2), make_lit(j, rng() % 2)});
+    }
+    auto pick = [](const std::vector<AigLit>& lits, AigLit k) { return lits[k >> 1] ^ (k & 1); };
+
+    // 串行参照
+    AigGraph serial = ref;
+    std::vector<AigLit> serial1, serial_out;
+    for (const Pair& p : level1) serial1.push_back(serial.addAnd(p.a, p.b));
+    for (const Pair& p : level2) serial_out.push_back(serial.addAnd(pick(serial1, p.a), pick(serial1, p.b)));
+    serial_out.insert(serial_out.end(), serial1.begin(), serial1.end());
+
+    AigGraph g = ref;
+    g.beginConcurrent(level1.size() + level2.size(), kThreads);
+    std::vector<std::vector<AigLit>> res1(kThreads), res2(kThreads);
+    std::vector<std::vector<size_t>> order1(kThreads), order2(kThreads);
+    for (unsigned t = 0; t < kThreads; ++t) {
+        for (size_t k = 0; k < level1.size(); ++k) order1[t].push_back(k);
+        for (size_t k = 0; k < level2.size(); ++k) order2[t].push_back(k);
+        std::shuffle(order1[t].begin(), order1[t].end(), rng);
+        std::shuffle(order2[t].begin(), order2[t].end(), rng);
+    }
+    std::atomic<unsigned> arrived{0};
+    auto work = [&](unsigned t) {
+        AigIdChunk chunk;
+        res1[t].assign(level1.size(), kAigNone);
+        res2[t].assign(level2.size(), kAigNone);
+        auto mine = [t](size_t k) { return k % kThreads == t || k % kThreads == (t + 1) % kThreads; };
+        auto barrier = [&](unsigned n) {
+            arrived.fetch_add(1);
+            while (arrived.load() < n * kThreads) std::this_thread::yield();
+        };
+        auto add1 = [&](size_t k) { res1[t][k] = g.addAndConcurrent(level1[k].a, level1[k].b, chunk); };
+        auto add2 = [&](size_t k) {
+            res2[t][k] = g.addAndConcurrent(pick(res1[t], level2[k].a), pick(res1[t], level2[k].b), chunk);
+        };
+        // 先建自己的一段和下一个线程的一段，每层都等所有线程建完再往下
+        for (size_t k = 0; k < level1.size(); ++k)
+            if (mine(k)) add1(k);
+        barrier(1);
+        for (size_t k : order1[t]) add1(k);
+        for (size_t k = 0; k < level2.size(); ++k)
+            if (mine(k)) add2(k);
+        barrier(2);
+        for (size_t k : order2[t]) add2(k);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < kThreads; ++t) threads.emplace_back(work, t);
+    for (std::thread& th : threads) th.join();
+    for (unsigned t = 1; t < kThreads; ++t) {
+        CHECK(res1[t] == res1[0]);
+        CHECK(res2[t] == res2[0]);
+    }
+
+    std::vector<AigLit> out = res2[0];
+    out.insert(out.end(), res1[0].begin(), res1[0].end());
+    g.endConcurrent(out);
+    CHECK(isTopological(g));
+    // 已有的对得到原来的字面量
+    for (size_t k = 0; k < level1.size(); ++k)
+        if (lit_id(serial1[k]) < ref.nodes.size()) CHECK(out[level2.size() + k] == serial1[k]);
+
+    g.outputs = out;
+    serial.outputs = serial_out;
+    CHECK(sameOutputs(g, serial, seed));
+}
+
+int main()
+{
+    for (const std::string& name : unitCases())
+        for (uint64_t seed = 1; seed <= 4; ++seed) checkConcurrent(name, seed);
+    std::printf("concurrent_test: ok\n");
+    return 0;
+}
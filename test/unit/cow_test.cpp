@@ -0,0 +1,123 @@
+#include "check.h"
+#include "strash_table.h"
+#include <algorithm>
+#include <unordered_map>
+
+// =============================================================
+// 写时复制的副本
+// =============================================================
+// 1. 复制 const 图不改动源对象：副本改写之后源图逐节点不变；副本销毁后
+//    源图的块重新归自己独占，写的时候不再复制
+// 2. 反复 "复制 -> 改写 -> 再复制" (副本都留着，层一直被共享)：每个副本里
+//    每个活 AND 都能从 strash 查回自己，源图不变
+// 3. 直接对 StrashTable 做同样的事，每个版本与自己的参照表逐键相同，
+//    层数不超过上限
+// -------------------------------------------------------------
+
+static void checkStrash(const AigGraph& g)
+{
+    for (AigId id = 1; id < g.nodes.size(); ++id) {
+        const AigNode n = g.nodes[id];
+        if (n.is_input || AigGraph::isDeadNode(n)) continue;
+        CHECK(g.lookupAnd(n.fanin0, n.fanin1) == make_lit(id));
+    }
+}
+
+// 改写之后 ID 可能不是拓扑序，仿真前先在另一个副本上回收
+static bool sameAfterReclaim(const AigGraph& ref, const AigGraph& g, uint64_t seed)
+{
+    AigGraph t = g;
+    t.reclaim(0.0);
+    return sameOutputs(ref, t, seed);
+}
+
+static void checkCopies(const std::string& name, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    AigGraph g = loadCase(name);
+    g.optimize();
+    const AigGraph ref = g;
+
+    {
+        const AigGraph& src = g;
+        AigGraph copy = src;
+        CHECK(g.nodes.sharedChunks() == g.nodes.chunkCount());
+        for (int k = 0; k < 20 && rotateOnce(copy, rng); ++k) {}
+        CHECK(sameStructure(g, ref));
+        CHECK(sameAfterReclaim(ref, copy, seed));
+        checkStrash(copy);
+    }
+    // ref 还共享着块；换一份自己的再看
+    AigGraph solo = loadCase(name);
+    {
+        AigGraph copy = solo;
+        (void)copy;
+    }
+    CHECK(solo.nodes.sharedChunks() == 0);
+
+    std::vector<AigGraph> chain;
+    chain.push_back(g);
+    for (int k = 0; k < 40; ++k) {
+        AigGraph next = chain.back();
+        for (int r = 0; r < 3 && rotateOnce(next, rng); ++r) {}
+        chain.push_back(std::move(next));
+    }
+    for (const AigGraph& c : chain) {
+        CHECK(sameAfterReclaim(ref, c, seed));
+        checkStrash(c);
+    }
+    CHECK(sameStructure(g, ref));
+    checkStrash(g);
+}
+
+static void checkTableVersions(uint64_t seed)
+{
+    using Ref = std::unordered_map<AigKey, AigLit, AigKeyHash>;
+    std::mt19937_64 rng(seed);
+    auto randomKey = [&] {
+        AigLit a = static_cast<AigLit>(rng() % 512), b = static_cast<AigLit>(rng() % 512);
+        return strash_key(std::min(a, b), std::max(a, b));
+    };
+    auto same = [](const StrashTable& t, const Ref& r) {
+        size_t n = 0;
+        t.forEach([&](const AigKey& key, AigLit lit) {
+            auto it = r.find(key);
+            CHECK(it != r.end() && it->second == lit);
+            ++n;
+        });
+        CHECK(n == r.size());
+        for (auto const& [key, lit] : r) CHECK(t.find(key) == lit);
+    };
+
+    std::vector<StrashTable> tables(1);
+    std::vector<Ref> refs(1);
+    for (int v = 0; v < 60; ++v) {
+        const StrashTable& src = tables.back();
+        StrashTable t = src;
+        Ref r = refs.back();
+        for (int k = 0; k < 1 + int(rng() % 40); ++k) {
+            AigKey key = randomKey();
+            if (rng() % 3 == 0) {
+                t.erase(key);
+                r.erase(key);
+            } else {
+                AigLit lit = static_cast<AigLit>(rng() % 1000);
+                t.insert(key, lit);
+                r[key] = lit;
+            }
+        }
+        CHECK(t.depth() <= 8);
+        tables.push_back(std::move(t));
+        refs.push_back(std::move(r));
+    }
+    for (size_t v = 0; v < tables.size(); ++v) same(tables[v], refs[v]);
+}
+
+int main()
+{
+    for (const std::string& name : unitCases())
+        for (uint64_t seed = 1; seed <= 2; ++seed) checkCopies(name, seed);
+    for (uint64_t seed = 1; seed <= 4; ++seed) checkTableVersions(seed);
+    std::printf("cow_test: ok\n");
+    return 0;
+}
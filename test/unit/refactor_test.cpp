@@ -0,0 +1,33 @@
+#include "check.h"
+
+// =============================================================
+// refactor
+// =============================================================
+// 每个用例跑一遍 refactor()：ID 保持拓扑序，仿真与原图逐位相同，
+// AND 个数不比原图多；再跑一遍同样不会变多。
+// -------------------------------------------------------------
+
+static void checkRefactor(const std::string& name)
+{
+    const AigGraph ref = loadCase(name);
+    AigGraph g = loadCase(name);
+    const size_t before = g.stats().area;
+
+    g.refactor();
+    CHECK(isTopological(g));
+    CHECK(sameOutputs(ref, g, 5, 32));
+    const size_t once = g.stats().area;
+    CHECK(once <= before);
+
+    g.refactor();
+    CHECK(isTopological(g));
+    CHECK(sameOutputs(ref, g, 6, 32));
+    CHECK(g.stats().area <= once);
+}
+
+int main()
+{
+    for (const std::string& name : unitCases()) checkRefactor(name);
+    std::printf("refactor_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "check.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+// =============================================================
+// 二进制快照
+// =============================================================
+// 写出再读回与原图相同；段表和节点段被改坏的文件必须以 std::runtime_error
+// 拒绝 (不能越界访问)，失败的读取不改动图；有死节点的图不能写出。
+// -------------------------------------------------------------
+
+static const std::string kPath = "/tmp/aig_snapshot_test_" + std::to_string(getpid()) + ".snap";
+
+static std::string readFile()
+{
+    std::ifstream in(kPath, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& bytes)
+{
+    std::ofstream out(kPath, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    CHECK(out.flush());
+}
+
+template <class T>
+static void patch(std::string& bytes, size_t offset, T value)
+{
+    CHECK(offset + sizeof(T) <= bytes.size());
+    std::memcpy(&bytes[offset], &value, sizeof(T));
+}
+
+template <class T>
+static T peek(const std::string& bytes, size_t offset)
+{
+    T value;
+    std::memcpy(&value, &bytes[offset], sizeof(T));
+    return value;
+}
+
+// 读入被改坏的文件：必须抛 std::runtime_error，图保持原样
+static void expectRejected(const std::string& bytes, const AigGraph& ref)
+{
+    writeFile(bytes);
+    AigGraph g = ref;
+    bool threw = false;
+    try {
+        g.loadSnapshot(kPath);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(sameStructure(g, ref));
+}
+
+// SnapshotHeader (snapshot.cpp) 里各字段的偏移
+constexpr size_t kNumInputsAt = 40, kNodesOffsetAt = 56, kInputsOffsetAt = 64, kOutputsOffsetAt = 72;
+
+static void checkSnapshot(const std::string& name)
+{
+    const AigGraph ref = loadCase(name);
+    ref.saveSnapshot(kPath);
+    const std::string good = readFile();
+
+    AigGraph g;
+    g.loadSnapshot(kPath);
+    CHECK(sameStructure(g, ref));
+    CHECK(sameOutputs(g, ref));
+
+    // 段表：长度与偏移相加会溢出的取值
+    std::string bad = good;
+    patch<uint64_t>(bad, kNumInputsAt, uint64_t(1) << 62);
+    expectRejected(bad, ref);
+    bad = good;
+    patch<uint64_t>(bad, kOutputsOffsetAt, ~uint64_t(0) - 8);
+    expectRejected(bad, ref);
+    bad = good;
+    patch<uint64_t>(bad, kNodesOffsetAt, peek<uint64_t>(good, kInputsOffsetAt) + 4096);
+    expectRejected(bad, ref);
+
+#ifndef AIG_SOA_NODES
+    // 节点段 (每节点一个结构体时可以按内存里的偏移直接改)：自环、指向后面的
+    // 节点、死节点、AND 变输入、输入变 AND
+    const uint64_t nodes_offset = peek<uint64_t>(good, kNodesOffsetAt);
+    auto node_at = [&](AigId id) {
+        size_t c = id >> NodeStore::kChunkBits;
+        const char* chunk = static_cast<const char*>(ref.nodes.chunkData(c));
+        return nodes_offset + c * NodeStore::kChunkBytes +
+               static_cast<size_t>(reinterpret_cast<const char*>(&ref.nodes[id]) - chunk);
+    };
+    AigId and_id = 0;
+    for (AigId id = 1; id < ref.nodes.size() && and_id == 0; ++id)
+        if (!ref.nodes[id].is_input) and_id = id;
+    if (and_id == 0) return;
+    const AigNode n = ref.nodes[and_id];
+    const AigId last = static_cast<AigId>(ref.nodes.size() - 1);
+    std::vector<AigNode> corrupt = {AigNode{n.fanin0, make_lit(and_id), false}, AigNode{0, 0, false},
+                                    AigNode{n.fanin0, n.fanin1, true}};
+    if (last > and_id) corrupt.push_back(AigNode{n.fanin0, make_lit(last), false});
+    for (const AigNode& c : corrupt) {
+        bad = good;
+        patch(bad, node_at(and_id), c);
+        expectRejected(bad, ref);
+    }
+    bad = good;
+    patch(bad, node_at(ref.inputs[0]), AigNode{0, 0, false});
+    expectRejected(bad, ref);
+#endif
+}
+
+// 有死节点的图不能写出 (读回时会被当作损坏的文件)
+static void checkSaveRejectsDead()
+{
+    AigGraph g = loadCase("case_simple/s1196");
+    for (AigId id = 1; id < g.nodes.size(); ++id) {
+        if (g.nodes[id].is_input) continue;
+        g.replace(id, g.nodes[id].fanin0);
+        break;
+    }
+    bool threw = false;
+    try {
+        g.saveSnapshot(kPath);
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    g.reclaim(0.0);
+    g.saveSnapshot(kPath);
+    AigGraph h;
+    h.loadSnapshot(kPath);
+    CHECK(sameStructure(g, h));
+}
+
+int main()
+{
+    for (const std::string& name : unitCases()) checkSnapshot(name);
+    checkSaveRejectsDead();
+    std::remove(kPath.c_str());
+    std::printf("snapshot_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "check.h"
+#include <algorithm>
+
+// =============================================================
+// 事务回滚
+// =============================================================
+// 在 g 上做一串 replace() 再回滚，g 应当和没动过的副本 h 完全一样：
+// 节点、PO、死节点数、扇出。之后两边做同样的 replace()，结果也要一样
+// (空闲表的顺序决定 addAnd 复用哪个槽位，引用计数决定删掉哪些节点；
+// 回滚后如果把它们作废重建，addAnd 就不再复用槽位，结果会不同)。
+// -------------------------------------------------------------
+
+// 随机挑一个活的 AND，换成它的某个 fanin 或常量；AND 都被换掉了就返回 false
+static bool pickReplacement(const AigGraph& g, std::mt19937_64& rng, AigId& id, AigLit& lit)
+{
+    std::vector<AigId> live;
+    for (AigId k = 1; k < g.nodes.size(); ++k)
+        if (!g.nodes[k].is_input && !AigGraph::isDeadNode(g.nodes[k])) live.push_back(k);
+    if (live.empty()) return false;
+    id = live[rng() % live.size()];
+    const AigNode n = g.nodes[id];
+    switch (rng() % 3) {
+    case 0: lit = n.fanin0; break;
+    case 1: lit = n.fanin1 ^ 1; break;
+    default: lit = static_cast<AigLit>(rng() % 2); break;
+    }
+    return true;
+}
+
+// 随机挑一个活节点 (输入或 AND) 的字面量
+static AigLit randomLit(const AigGraph& g, std::mt19937_64& rng)
+{
+    for (;;) {
+        AigId id = static_cast<AigId>(1 + rng() % (g.nodes.size() - 1));
+        if (!AigGraph::isDeadNode(g.nodes[id])) return make_lit(id, rng() % 2);
+    }
+}
+
+static std::vector<AigId> sortedFanouts(const AigGraph& g, AigId id)
+{
+    FanoutRange r = g.fanouts(id);
+    std::vector<AigId> v(r.begin(), r.end());
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+static void checkRollback(const std::string& name, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    AigGraph g = loadCase(name);
+
+    // 先在事务外 replace 一次：引用计数、空闲表、扇出溢出表都已经在用。
+    // h 重放同样的操作而不是复制 g (复制不带这些簿记)
+    AigGraph h = loadCase(name);
+    AigId id;
+    AigLit lit;
+    CHECK(pickReplacement(g, rng, id, lit));
+    g.replace(id, lit);
+    h.replace(id, lit);
+
+    g.beginTransaction();
+    for (int k = 0; k < 20 && pickReplacement(g, rng, id, lit); ++k) {
+        g.replace(id, lit);
+        g.addAnd(randomLit(g, rng), randomLit(g, rng));
+    }
+    g.addOutput(make_lit(g.inputs[0]));
+    g.rollbackTransaction();
+
+    CHECK(sameStructure(g, h));
+    CHECK(g.deadCount() == h.deadCount());
+    for (AigId id = 0; id < g.nodes.size(); ++id) CHECK(sortedFanouts(g, id) == sortedFanouts(h, id));
+
+    // 先 addAnd 再 replace：回滚后的第一个新节点就要复用同一个空闲槽位
+    for (int k = 0; k < 20; ++k) {
+        AigLit x = randomLit(g, rng), y = randomLit(g, rng);
+        CHECK(g.addAnd(x, y) == h.addAnd(x, y));
+        if (!pickReplacement(g, rng, id, lit)) break;
+        g.replace(id, lit);
+        h.replace(id, lit);
+    }
+    CHECK(sameStructure(g, h));
+    CHECK(g.deadCount() == h.deadCount());
+}
+
+int main()
+{
+    for (const std::string& name : unitCases())
+        for (uint64_t seed = 1; seed <= 4; ++seed) checkRollback(name, seed);
+    std::printf("transaction_test: ok\n");
+    return 0;
+}